@@ -3,21 +3,45 @@
 
 #include "MTSPBCInstance.hpp"
 #include "MTSPBC_ds.hpp"
+#include "TwoLevelList.hpp"
 #include <cstddef>
 #include <cstdint>
+#include <span>
 #include <vector>
 #include <optional>
 
 
+// representação da rota: vetor contíguo, ou lista de dois níveis para rotas longas
+enum class TourBackend { vector, two_level };
+
+
 class Cht {
     private:
         uint32_t obj_;
-        std::vector<uint32_t> tour_;
-        std::vector<uint32_t> events_;
+        mutable std::vector<uint32_t> tour_;
+        mutable std::vector<uint32_t> events_;
         bool complete_tour_;                    // set true it tour starts and ends at depot (0 node)
+        mutable std::vector<uint32_t> node_pos_;        // primeira posição de cada nó, válida abaixo de indexed_upto_
+        mutable size_t indexed_upto_;
+        TourBackend backend_;
+        TwoLevelList list_;                     // só usada com TourBackend::two_level
+        mutable bool list_ahead_;               // list_ tem alterações que tour_ e events_ ainda não têm
+        mutable size_t flat_upto_;              // com list_ahead_, tour_ e events_ ainda valem antes desta posição
+        mutable std::vector<uint32_t> window_;  // trecho lido da lista pelo evaluate_2opt
+        bool list_behind_;                      // tour_ tem alterações que list_ ainda não tem
+        mutable const MTSPBCInstance* instance_;        // custos para refazer os eventos ao sincronizar
+        void stale_from_(const size_t pos) const noexcept;
+        void reindex_() const;
+        void materialize_() const;
+        [[nodiscard]] uint32_t node_at_(const size_t pos) const;
+        void use_vector_();
+        void use_list_(const MTSPBCInstance& instance);
+        void check_complete_listed_() noexcept;
         uint32_t compute_events_(const MTSPBCInstance& instance);
         // uint32_t compute_events_(const MTSPBCInstance& instance);
         uint32_t compute_events_(const uint32_t inserted_pos, const MTSPBCInstance& instance);
+        void insert_event_(const size_t pos, const MTSPBCInstance& instance);
+        void remove_event_(const size_t pos, const uint32_t node, const MTSPBCInstance& instance);
         uint32_t compute_obj_insert_(size_t pos_A, size_t pos_B, size_t pos_C, const MTSPBCInstance& instance);
         uint32_t compute_obj_insert_(const bool at_end, const MTSPBCInstance& instance);
         uint32_t compute_obj_insert_(const uint32_t pos_i, const uint32_t pos_e, const MTSPBCInstance& instance);
@@ -27,6 +51,8 @@ class Cht {
 
     public:
         Cht();
+        void set_backend(const TourBackend backend);
+        [[nodiscard]] TourBackend get_backend() const noexcept;
         uint32_t insert_node(const uint32_t node, const size_t pos, const MTSPBCInstance& instance);
         uint32_t remove_node(const size_t pos, const MTSPBCInstance& instance);
         uint32_t push_back(const uint32_t node, const MTSPBCInstance& instance);
@@ -38,17 +64,27 @@ class Cht {
         uint32_t remove_subtour(const MTSPBCInstance& instance, const uint32_t pos_i, const uint32_t pos_e);
         uint32_t reverse_subtour(const MTSPBCInstance& instance, const uint32_t pos_i, const uint32_t pos_e);
         uint32_t reverse_tour(const MTSPBCInstance& instance);
+        void restore_suffix(const size_t from, std::span<const uint32_t> tour, std::span<const uint32_t> events, const uint32_t obj, const bool complete);
+        [[nodiscard]] int64_t evaluate_insert(const uint32_t node, const size_t pos, const MTSPBCInstance& instance) const;
+        [[nodiscard]] int64_t evaluate_remove(const size_t pos, const MTSPBCInstance& instance) const;
+        [[nodiscard]] int64_t evaluate_2opt(const uint32_t pos_i, const uint32_t pos_e, const MTSPBCInstance& instance) const;
+        [[nodiscard]] int64_t evaluate_or_opt(const uint32_t pos_i, const uint32_t pos_e, const uint32_t to_pos, const MTSPBCInstance& instance) const;
         [[nodiscard]] uint32_t get_obj() const noexcept;
-        [[nodiscard]] std::vector<uint32_t> get_tour() const noexcept;
+        [[nodiscard]] std::vector<uint32_t> get_tour() const;
         [[nodiscard]] std::optional<size_t> get_pos_for_node(const uint32_t node) const;
         [[nodiscard]] uint32_t get_node_at_pos(const size_t pos) const;
         [[nodiscard]] size_t n_nodes() const noexcept;
-        [[nodiscard]] uint32_t n_events() const noexcept;
-        [[nodiscard]] std::vector<uint32_t> get_events() const noexcept;
+        [[nodiscard]] uint32_t n_events() const;
+        [[nodiscard]] std::vector<uint32_t> get_events() const;
+        [[nodiscard]] std::span<const uint32_t> tour_view() const { materialize_(); return tour_; }       // sem cópia, válido até a próxima alteração
+        [[nodiscard]] std::span<const uint32_t> events_view() const { materialize_(); return events_; }
+        [[nodiscard]] std::span<const uint32_t> tour_prefix(const size_t n) const;
+        [[nodiscard]] std::span<const uint32_t> events_prefix(const size_t n) const;
         [[nodiscard]] bool get_complete() const noexcept;
         [[nodiscard]] std::optional<uint32_t> get_node_at_event(const uint32_t e_time) const;
         [[nodiscard]] Edge edge(const uint32_t edge_i) const;
         [[nodiscard]] Edge edge_at_event(const uint32_t e_time) const;
         [[nodiscard]] uint32_t event_index(const uint32_t e_time) const;
+        [[nodiscard]] size_t last_event_at(const uint32_t e_time) const;
         bool check_complete_tour_();
 };
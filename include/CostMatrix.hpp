@@ -0,0 +1,184 @@
+#pragma once
+
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+
+// allocator de blocos alinhados a linha de cache, usado pela matriz de custos
+template <typename T, size_t Alignment>
+struct AlignedAllocator {
+    using value_type = T;
+    template <typename U> struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+    AlignedAllocator() noexcept = default;
+    template <typename U> AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+    T* allocate(size_t n) {
+        size_t bytes { ((n * sizeof(T) + Alignment - 1) / Alignment) * Alignment };
+        void* p { std::aligned_alloc(Alignment, bytes) };
+        if (!p) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(p);
+    }
+    void deallocate(T* p, size_t) noexcept { std::free(p); }
+
+    template <typename U> bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept { return true; }
+    template <typename U> bool operator!=(const AlignedAllocator<U, Alignment>&) const noexcept { return false; }
+};
+
+
+// formato de armazenamento: matriz cheia com linhas alinhadas, ou só o triângulo inferior (com a diagonal)
+enum class CostLayout : uint32_t { full = 0, triangle = 1 };
+
+
+class CostMatrix {
+
+    private:
+
+    static constexpr size_t alignment_ { 64 };
+    static constexpr size_t row_pad_ { alignment_ / sizeof(uint32_t) };
+
+    uint32_t n_nodes_;
+    CostLayout layout_;
+    uint32_t entry_bytes_;                                          // 4 (uint32_t) or 2 (uint16_t)
+    size_t stride_;                                                 // full layout: entries per row, padded to a cache line
+    std::vector<std::byte, AlignedAllocator<std::byte, alignment_>> storage_;
+    const std::byte* data_;                                         // storage_ or an external (mapped) block
+    std::shared_ptr<const void> owner_;                             // keeps an external block alive
+
+    // formato e largura resolvidos uma vez em resolve_(): get() escolhe o acesso num único switch
+    enum class Access : uint32_t { full_32, full_16, triangle_32, triangle_16 };
+    Access access_;
+    std::vector<size_t> row_start_;                                 // só no triângulo: hi * (hi + 1) / 2 de cada linha
+
+    void resolve_() {
+        const bool narrow { entry_bytes_ == sizeof(uint16_t) };
+        row_start_.clear();
+        if (layout_ == CostLayout::full) {
+            access_ = narrow ? Access::full_16 : Access::full_32;
+            return;
+        }
+        access_ = narrow ? Access::triangle_16 : Access::triangle_32;
+        row_start_.resize(n_nodes_);
+        for (size_t row = 0; row < n_nodes_; row++) {
+            row_start_[row] = row * (row + 1) / 2;
+        }
+    }
+
+    template <typename Entry>
+    [[nodiscard]] uint32_t get_full_(const uint32_t node_A, const uint32_t node_B) const noexcept {
+        return reinterpret_cast<const Entry*>(data_)[node_A * stride_ + node_B];
+    }
+
+    // linha do maior nó, sem desvio: troca A e B quando A < B
+    template <typename Entry>
+    [[nodiscard]] uint32_t get_triangle_(const uint32_t node_A, const uint32_t node_B) const noexcept {
+        const uint32_t swap { (node_A ^ node_B) & (0u - static_cast<uint32_t>(node_A < node_B)) };
+        return reinterpret_cast<const Entry*>(data_)[row_start_[node_A ^ swap] + (node_B ^ swap)];
+    }
+
+    public:
+
+    CostMatrix() : n_nodes_(0), layout_(CostLayout::full), entry_bytes_(sizeof(uint32_t)), stride_(0), data_(nullptr) { resolve_(); }
+    explicit CostMatrix(const uint32_t n_nodes)
+    : n_nodes_(n_nodes),
+    layout_(CostLayout::full),
+    entry_bytes_(sizeof(uint32_t)),
+    stride_(padded_stride(n_nodes)),
+    storage_(block_bytes(n_nodes, CostLayout::full, sizeof(uint32_t))),
+    data_(storage_.data()) { resolve_(); }
+    CostMatrix(const CostMatrix& other)
+    : n_nodes_(other.n_nodes_), layout_(other.layout_), entry_bytes_(other.entry_bytes_), stride_(other.stride_), storage_(other.storage_),
+    data_(other.owns_() ? storage_.data() : other.data_), owner_(other.owner_), access_(other.access_), row_start_(other.row_start_) {}
+    CostMatrix(CostMatrix&& other) noexcept = default;
+    CostMatrix& operator=(CostMatrix other) noexcept {
+        n_nodes_ = other.n_nodes_;
+        layout_ = other.layout_;
+        entry_bytes_ = other.entry_bytes_;
+        stride_ = other.stride_;
+        storage_ = std::move(other.storage_);
+        data_ = other.data_;
+        owner_ = std::move(other.owner_);
+        access_ = other.access_;
+        row_start_ = std::move(other.row_start_);
+        return *this;
+    }
+
+    // view over an external block with the layout of block_bytes
+    static CostMatrix view(const uint32_t n_nodes, const CostLayout layout, const uint32_t entry_bytes, const std::byte* data, std::shared_ptr<const void> owner) {
+        if (entry_bytes != sizeof(uint32_t) && entry_bytes != sizeof(uint16_t)) {
+            throw std::logic_error("error: cost entries must have 2 or 4 bytes");
+        }
+        CostMatrix m;
+        m.n_nodes_ = n_nodes;
+        m.layout_ = layout;
+        m.entry_bytes_ = entry_bytes;
+        m.stride_ = (layout == CostLayout::full) ? padded_stride(n_nodes) : 0;
+        m.data_ = data;
+        m.owner_ = std::move(owner);
+        m.resolve_();
+        return m;
+    }
+    static constexpr size_t padded_stride(const uint32_t n_nodes) noexcept {
+        return ((static_cast<size_t>(n_nodes) + row_pad_ - 1) / row_pad_) * row_pad_;
+    }
+    static constexpr size_t block_bytes(const uint32_t n_nodes, const CostLayout layout, const uint32_t entry_bytes) noexcept {
+        size_t n { n_nodes };
+        size_t entries { (layout == CostLayout::full) ? padded_stride(n_nodes) * n : n * (n + 1) / 2 };
+        return entries * entry_bytes;
+    }
+    static CostMatrix compress(CostMatrix&& matrix);
+
+    // acesso sem verificação de limites, para laços críticos
+    [[nodiscard]] uint32_t get(const uint32_t node_A, const uint32_t node_B) const noexcept {
+        switch (access_) {
+            case Access::full_32:
+                return get_full_<uint32_t>(node_A, node_B);
+            case Access::full_16:
+                return get_full_<uint16_t>(node_A, node_B);
+            case Access::triangle_32:
+                return get_triangle_<uint32_t>(node_A, node_B);
+            case Access::triangle_16:
+                return get_triangle_<uint16_t>(node_A, node_B);
+        }
+        return 0;
+    }
+    void set(const uint32_t node_A, const uint32_t node_B, const uint32_t value) {
+        mutable_data()[node_A * stride_ + node_B] = value;
+    }
+    [[nodiscard]] const std::byte* data() const noexcept { return data_; }
+    // linhas da matriz cheia em 32 bits, para preencher a matriz
+    [[nodiscard]] uint32_t* mutable_data() {
+        if (!owns_()) {
+            throw std::logic_error("error: cannot write to a mapped cost matrix");
+        }
+        if (layout_ != CostLayout::full || entry_bytes_ != sizeof(uint32_t)) {
+            throw std::logic_error("error: cannot write to a compressed cost matrix");
+        }
+        return reinterpret_cast<uint32_t*>(storage_.data());
+    }
+    [[nodiscard]] uint32_t at(const uint32_t node_A, const uint32_t node_B) const {
+        if (node_A >= n_nodes_ || node_B >= n_nodes_) {
+            throw std::out_of_range("error: node does not exist");
+        }
+        return get(node_A, node_B);
+    }
+    [[nodiscard]] uint32_t n() const noexcept { return n_nodes_; }
+    [[nodiscard]] size_t stride() const noexcept { return stride_; }
+    [[nodiscard]] CostLayout layout() const noexcept { return layout_; }
+    [[nodiscard]] uint32_t entry_bytes() const noexcept { return entry_bytes_; }
+    [[nodiscard]] size_t size_bytes() const noexcept { return block_bytes(n_nodes_, layout_, entry_bytes_); }
+
+    private:
+
+    [[nodiscard]] bool owns_() const noexcept { return !storage_.empty() && data_ == storage_.data(); }
+};
@@ -0,0 +1,13 @@
+#pragma once
+
+
+#include "CostMatrix.hpp"
+#include "CoverIndex.hpp"
+#include "MTSPBC_ds.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+void segment_circle_windows(const double* xs, const double* ys, const size_t m, const Coord& a, const Coord& b, const double radius, double* lo, double* hi);
+CoverIndex build_cover(const std::vector<Coord>& coordinates, const CostMatrix& cost_matrix, const uint32_t r_radius);
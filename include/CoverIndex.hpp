@@ -0,0 +1,58 @@
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+
+struct CoverWindow {
+    uint32_t covered_node;
+    double LB;
+    double UB;
+};
+
+
+struct CoverTriple {
+    uint32_t covered_node;
+    uint32_t departure_node;
+    uint32_t arrival_node;
+    double LB;
+    double UB;
+};
+
+
+class CoverIndex {
+
+    private:
+
+    uint32_t n_nodes_;
+    std::vector<uint32_t> offsets_storage_;
+    std::vector<CoverWindow> windows_storage_;
+    std::span<const uint32_t> edge_offsets_;    // CSR offsets, edge (i, j) owns [offsets[i*n+j], offsets[i*n+j+1])
+    std::span<const CoverWindow> windows_;      // windows sorted by (departure, arrival, covered)
+    std::shared_ptr<const void> owner_;         // keeps an external (mapped) block alive
+
+    [[nodiscard]] const CoverWindow* find_(const uint32_t covered_node, const uint32_t departure_node, const uint32_t arrival_node) const;
+    void attach_storage_();
+
+    public:
+
+    CoverIndex();
+    CoverIndex(const uint32_t n_nodes, std::vector<CoverTriple>&& triples);
+    CoverIndex(const CoverIndex& other);
+    CoverIndex(CoverIndex&& other) noexcept = default;
+    CoverIndex& operator=(CoverIndex other) noexcept;
+    static CoverIndex view(const uint32_t n_nodes, std::span<const uint32_t> edge_offsets, std::span<const CoverWindow> windows, std::shared_ptr<const void> owner);
+
+    [[nodiscard]] double get_LB(const uint32_t covered_node, const uint32_t departure_node, const uint32_t arrival_node) const;
+    [[nodiscard]] double get_UB(const uint32_t covered_node, const uint32_t departure_node, const uint32_t arrival_node) const;
+    [[nodiscard]] bool covers(const uint32_t covered_node, const uint32_t departure_node, const uint32_t arrival_node) const;
+    [[nodiscard]] std::span<const CoverWindow> covered_by(const uint32_t departure_node, const uint32_t arrival_node) const;
+    [[nodiscard]] std::span<const uint32_t> edge_offsets() const noexcept;
+    [[nodiscard]] std::span<const CoverWindow> windows() const noexcept;
+    [[nodiscard]] size_t n_windows() const noexcept;
+    [[nodiscard]] uint32_t n() const noexcept;
+};
@@ -0,0 +1,13 @@
+#pragma once
+
+
+#include "CostMatrix.hpp"
+#include "MTSPBC_ds.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+void distance_row(const double* xs, const double* ys, const size_t m, const Coord& a, uint32_t* out);
+CostMatrix build_cost_matrix(const std::vector<Coord>& coordinates);
+std::vector<uint32_t> build_neighbour_lists(const CostMatrix& cost_matrix, const uint32_t n_neighbours);
@@ -0,0 +1,36 @@
+#pragma once
+
+
+#include "MTSPBCInstance.hpp"
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+
+// cabeçalho do formato binário da instância; seções alinhadas a 64 bytes
+struct InstanceCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t source_checksum;       // checksum dos arquivos texto de origem
+    uint64_t file_size;
+    uint32_t k_vehicles;
+    uint32_t n_nodes;
+    uint32_t r_radius;
+    uint32_t cover_window_size;     // sizeof(CoverWindow) do escritor
+    uint64_t coord_offset;
+    uint64_t cost_offset;
+    uint64_t cost_stride;           // entradas por linha no formato cheio, 0 no triangular
+    uint32_t cost_layout;           // CostLayout
+    uint32_t cost_entry_bytes;      // 4 (uint32_t) ou 2 (uint16_t)
+    uint64_t cover_offsets_offset;
+    uint64_t cover_windows_offset;
+    uint64_t n_cover_windows;
+};
+
+
+uint64_t source_checksum(const std::vector<std::string>& filepaths);
+std::optional<uint64_t> read_cache_checksum(const std::string& cache_filepath);
+void write_instance_cache(const std::string& cache_filepath, const InstanceData& data, const uint64_t checksum);
+InstanceData open_instance_cache(const std::string& cache_filepath);
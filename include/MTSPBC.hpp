@@ -1,14 +1,18 @@
 #pragma once
 
 
+#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <optional>
+#include <span>
 #include <utility>
 #include <vector>
 #include "Cht.hpp"
 #include "MTSPBC_ds.hpp"
 #include "MTSPBCInstance.hpp"
+#include "SegmentTree.hpp"
+#include "Trajectories.hpp"
 
 
 class MTSPBC {
@@ -19,15 +23,78 @@ class MTSPBC {
     uint32_t n_nodes_;
     uint32_t r_radius_;
     std::vector<Cht> tours_;
-    std::vector<std::pair<uint32_t, uint32_t>> events_;
-    std::vector<uint32_t> max_distance_events_;
+    // linha do tempo e distâncias são recalculadas sob demanda, só quando há veículos alterados
+    mutable std::vector<std::pair<uint32_t, uint32_t>> events_;
+    mutable std::vector<uint32_t> max_distance_events_;
+    mutable SegmentTree distance_tree_;                 // max e soma de max_distance_events_ por intervalo de eventos
     bool feasible_;
-    uint32_t max_distance_value_;
+    mutable uint32_t max_distance_value_;
+    mutable std::vector<char> dirty_vehicles_;          // veículos alterados desde a última sincronização
+    mutable std::vector<size_t> dirty_from_;            // primeira posição alterada de cada veículo, lida no sync_()
+    mutable bool dirty_;
+    mutable std::vector<uint32_t> sweep_cursor_;        // buffers do cálculo de distâncias, reaproveitados entre chamadas
+    mutable std::vector<Coord> sweep_position_;
+    mutable std::vector<std::span<const uint32_t>> sweep_tours_;
+    mutable std::vector<std::span<const uint32_t>> sweep_events_;
+    mutable Trajectories trajectories_;                 // arestas das rotas em SoA, para interpolar em blocos
+    mutable std::vector<uint32_t> block_times_;
+    mutable std::vector<double> block_x_;               // posição do veículo v no tempo q do bloco em [q * k_vehicles_ + v]
+    mutable std::vector<double> block_y_;
+    static constexpr size_t block_events_ { 64 };
+    mutable std::vector<Coord> sweep_points_;           // posições e fecho convexo do max_separation
+    mutable std::vector<Coord> sweep_hull_;
+    static constexpr uint32_t calipers_min_vehicles_ { 24 };      // a partir daqui, fecho convexo em vez de todos os pares
+    mutable std::array<std::vector<uint32_t>, 2> eval_tours_;        // rotas candidatas dos evaluate_*
+    mutable std::array<std::vector<uint32_t>, 2> eval_events_;
+    mutable std::vector<std::pair<uint32_t, uint32_t>> eval_timeline_;
+    // journal da transação aberta por begin(): trechos das rotas e agregados antes das alterações
+    bool in_transaction_;
+    std::vector<TourCheckpoint> journal_;               // entradas reaproveitadas entre transações
+    size_t journal_size_;
+    std::vector<uint32_t> journal_slot_;                // entrada de cada veículo, ou no_slot_
+    uint32_t saved_total_obj_;
+    bool saved_feasible_;
+    mutable bool timeline_saved_;
+    mutable std::vector<std::pair<uint32_t, uint32_t>> saved_events_;
+    mutable std::vector<uint32_t> saved_distances_;
+    mutable uint32_t saved_max_distance_;
+    static constexpr uint32_t no_slot_ { UINT32_MAX };
+    mutable std::vector<uint32_t> node_vehicle_;        // último veículo encontrado para cada nó
+    TourBackend backend_;                               // representação das rotas, inclusive das criadas depois
+    // separação de cada par (k, l) nos eventos de cada veículo m, em [pair_index_(k, l) * k_vehicles_ + m]
+    mutable std::vector<PairSeparation> pair_max_;
+    mutable uint32_t pair_k_;                           // número de veículos com que pair_max_ foi montado
+    mutable std::vector<char> changed_vehicles_;        // veículos alterados desde a última atualização de pair_max_
+    mutable bool pairs_dirty_;                          // pair_max_ e max_distance_value_ atrasados em relação à linha do tempo
+    // max_distance_events_ é refeito só quando lido, e só dos eventos a partir deste instante
+    mutable uint32_t distances_from_;
+    mutable std::vector<std::pair<size_t, PairSeparation>> saved_pairs_;     // entradas de pair_max_ reescritas na transação, com o valor anterior
+    mutable SegmentTree saved_tree_;
+    std::vector<char> saved_changed_vehicles_;
+    uint32_t saved_pair_k_;
+    bool saved_pairs_dirty_;
+    uint32_t saved_distances_from_;
+    static constexpr uint32_t distances_synced_ { UINT32_MAX };
+    static constexpr size_t clean_from_ { SIZE_MAX };
     uint32_t compute_obj_();
-    uint32_t collect_events_();
     uint32_t collect_events_(const uint32_t& vehicle, const uint32_t& node_index);
+    void mark_dirty_(const uint32_t vehicle, const size_t first_pos);
+    void checkpoint_(const uint32_t vehicle, const size_t first_pos);
+    void sync_() const;
+    void sync_distances_() const;
+    void sync_pairs_() const;
+    void interpolate_block_(std::span<const uint32_t> times) const;
+    void load_positions_(const size_t q, const uint32_t e_vehicle, const uint32_t e_time,
+                         const std::vector<std::span<const uint32_t>>& tours, const std::vector<std::span<const uint32_t>>& events) const;
+    [[nodiscard]] size_t pair_index_(const uint32_t k, const uint32_t l) const noexcept;
+    void update_pairs_() const;
+    [[nodiscard]] PairSeparation pair_separation_unchecked_(const uint32_t k, const uint32_t l) const noexcept;
     uint32_t compute_max_distances_(uint32_t changed_e_index);
-    uint32_t compute_max_distances_();
+    uint32_t compute_max_distances_(const uint32_t from_time) const;
+    uint32_t sweep_(const std::vector<std::pair<uint32_t, uint32_t>>& timeline, const std::vector<std::span<const uint32_t>>& tours,
+                    const std::vector<std::span<const uint32_t>>& events, std::vector<uint32_t>* per_event, const size_t first) const;
+    [[nodiscard]] std::pair<size_t, size_t> event_range_(const uint32_t t_1, const uint32_t t_2) const;
+    MoveDelta evaluate_candidates_(const uint32_t n_changed, const std::array<uint32_t, 2>& vehicles, const std::array<size_t, 2>& first_changed) const;
     bool check_feasibility_();
 
 
@@ -39,20 +106,34 @@ class MTSPBC {
     // MSTPBC methods
     uint32_t create_vehicle();
     uint32_t remove_vehicle(const uint32_t vehicle_index);
+    void set_tour_backend(const TourBackend backend);
     uint32_t set_radius(const uint32_t r_radius);
     void save_solution(const std::string& filepath, const std::string& tour_filepath);
+    void save_trajectories(const std::string& filepath, const uint32_t time_step) const;
+    void begin();
+    uint32_t commit();
+    void rollback();
+    [[nodiscard]] bool in_transaction() const noexcept;
     [[nodiscard]] uint32_t get_total_obj() const noexcept;
-    [[nodiscard]] std::vector<std::pair<uint32_t, uint32_t>> get_events() const noexcept;
+    [[nodiscard]] std::vector<std::pair<uint32_t, uint32_t>> get_events() const;
     [[nodiscard]] bool get_feasibility() const noexcept;
-    [[nodiscard]] uint32_t get_max_distance() const noexcept;
-    [[nodiscard]] std::vector<uint32_t> get_distances() const noexcept;
+    [[nodiscard]] uint32_t get_max_distance() const;
+    [[nodiscard]] PairSeparation pair_separation(const uint32_t vehicle_1, const uint32_t vehicle_2) const;
+    [[nodiscard]] ContinuousSeparation continuous_max_distance() const;
+    [[nodiscard]] std::vector<uint32_t> get_distances() const;
+    [[nodiscard]] uint64_t get_distance_sum() const;
+    [[nodiscard]] uint32_t max_distance_in(const uint32_t t_1, const uint32_t t_2) const;
+    [[nodiscard]] uint64_t distance_sum_in(const uint32_t t_1, const uint32_t t_2) const;
+    [[nodiscard]] std::span<const std::pair<uint32_t, uint32_t>> timeline_view() const;
+    [[nodiscard]] std::span<const uint32_t> distances_view() const;
     [[nodiscard]] uint32_t get_n_nodes() const noexcept;
     [[nodiscard]] uint32_t get_k_vehicles() const noexcept;
     [[nodiscard]] uint32_t get_r_radius() const noexcept;
     [[nodiscard]] uint32_t get_cost(const uint32_t node_A, const uint32_t node_B) const;
     [[nodiscard]] std::pair<uint32_t, uint32_t> get_event(const uint32_t e_index) const;
-    [[nodiscard]] uint32_t get_n_events() const noexcept;
+    [[nodiscard]] uint32_t get_n_events() const;
     [[nodiscard]] Coord get_coord(uint32_t node) const;
+    [[nodiscard]] bool is_neighbour(const uint32_t node, const uint32_t candidate) const;
 
     // Cht wrapper methods
     uint32_t insert_node(const uint32_t vehicle, const uint32_t node, const size_t pos);
@@ -71,12 +152,24 @@ class MTSPBC {
     [[nodiscard]] uint32_t get_obj_vehicle(const uint32_t vehicle) const;
     [[nodiscard]] std::vector<uint32_t> get_tour(const uint32_t vehicle) const;
     [[nodiscard]] std::optional<size_t> get_pos_for_node(const uint32_t vehicle, const uint32_t node) const;
+    [[nodiscard]] std::optional<uint32_t> get_vehicle_for_node(const uint32_t node) const;
     [[nodiscard]] uint32_t get_node_at_pos(const uint32_t vehicle, const size_t pos) const;
     [[nodiscard]] uint32_t get_node_at_event(const uint32_t vehicle, const uint32_t e_time) const;
     [[nodiscard]] bool get_complete_tour(const uint32_t vehicle) const;
     [[nodiscard]] std::vector<uint32_t> get_vehicle_events(const uint32_t vehicle) const;
+    [[nodiscard]] std::span<const uint32_t> tour_view(const uint32_t vehicle) const;
+    [[nodiscard]] std::span<const uint32_t> events_view(const uint32_t vehicle) const;
     [[nodiscard]] Edge edge(const uint32_t vehicle, const uint32_t edge_i) const;
     [[nodiscard]] Edge edge_at_event(const uint32_t vehicle, const uint32_t e_time) const;
     [[nodiscard]] uint32_t event_index(const uint32_t vehicle, const uint32_t e_time) const;
+    [[nodiscard]] size_t last_event_at(const uint32_t vehicle, const uint32_t e_time) const;
     [[nodiscard]] uint32_t dist_at_event(const uint32_t e_index) const;
+
+    // avaliação de movimentos sem alterar a solução
+    [[nodiscard]] MoveDelta evaluate_insert(const uint32_t vehicle, const uint32_t node, const size_t pos) const;
+    [[nodiscard]] MoveDelta evaluate_remove(const uint32_t vehicle, const size_t pos) const;
+    [[nodiscard]] MoveDelta evaluate_relocate(const uint32_t from_vehicle, const size_t from_pos, const uint32_t to_vehicle, const size_t to_pos) const;
+    [[nodiscard]] MoveDelta evaluate_swap(const uint32_t vehicle_1, const size_t pos_1, const uint32_t vehicle_2, const size_t pos_2) const;
+    [[nodiscard]] MoveDelta evaluate_2opt(const uint32_t vehicle, const uint32_t pos_i, const uint32_t pos_e) const;
+    [[nodiscard]] MoveDelta evaluate_or_opt(const uint32_t vehicle, const uint32_t pos_i, const uint32_t pos_e, const uint32_t to_pos) const;
 };
@@ -1,16 +1,20 @@
 #pragma once
 
 
+#include "CostMatrix.hpp"
+#include "CoverIndex.hpp"
 #include "MTSPBC_ds.hpp"
+#include "SpatialGrid.hpp"
 #include <cstdint>
+#include <optional>
+#include <span>
 #include <string>
 #include <vector>
 
 
 struct InstanceData {
-    std::vector<std::vector<uint32_t>> cost_matrix;
-    std::vector<std::vector<std::vector<double>>> LB;
-    std::vector<std::vector<std::vector<double>>> UB;
+    CostMatrix cost_matrix;
+    CoverIndex cover;
     std::vector<Coord> coordinates;
     uint32_t k_vehicles;
     uint32_t n_nodes;
@@ -22,24 +26,50 @@ class MTSPBCInstance {
 
     private:
 
-    const std::vector<std::vector<uint32_t>> cost_matrix_;
-    const std::vector<std::vector<std::vector<double>>> LB_;
-    const std::vector<std::vector<std::vector<double>>> UB_;
+    const CostMatrix cost_matrix_;
+    const CoverIndex cover_;
     const std::vector<Coord> coordinates_;
     const uint32_t k_vehicles_;
     const uint32_t n_nodes_;
     const uint32_t r_radius_;
+    const uint32_t n_neighbours_;
+    const std::vector<uint32_t> neighbours_;        // n_neighbours_ nós mais próximos de cada nó, em ordem de custo
+    const SpatialGrid grid_;                        // índice espacial das coordenadas, células do tamanho do raio
 
-    MTSPBCInstance(const InstanceData& data);
+    static void parse_coordinates_(const std::string& filepath, InstanceData& data);
     static InstanceData parse_instance(const std::string& filepath, const std::string& dist_filepath, const std::string& cover_filepath);
+    static InstanceData parse_instance(const std::string& filepath, const std::string& dist_filepath);
+    static InstanceData parse_instance(const std::string& filepath);
+    static InstanceData make_data_(std::vector<Coord>&& coordinates, const uint32_t k_vehicles, const uint32_t r_radius,
+                                   std::optional<CostMatrix>&& cost_matrix, std::optional<CoverIndex>&& cover);
+    static InstanceData load_cached_(const std::string& filepath, const std::string& dist_filepath, const std::string& cover_filepath, const std::string& cache_filepath);
 
     public:
 
+    static constexpr uint32_t default_neighbours { 16 };
+
     MTSPBCInstance(const std::string& instance_filepath, const std::string& dist_filepath, const std::string& cover_filepath);
+    MTSPBCInstance(const std::string& instance_filepath, const std::string& dist_filepath);
+    MTSPBCInstance(const std::string& instance_filepath, const std::string& dist_filepath, const std::string& cover_filepath, const std::string& cache_filepath);
+    explicit MTSPBCInstance(const std::string& filepath);      // binary cache, or .bc file with distances and cover computed in-process
+    explicit MTSPBCInstance(InstanceData&& data);
+    MTSPBCInstance(std::vector<Coord>&& coordinates, const uint32_t k_vehicles, const uint32_t r_radius,
+                   std::optional<CostMatrix>&& cost_matrix = std::nullopt, std::optional<CoverIndex>&& cover = std::nullopt);
 
     [[nodiscard]] double get_LB(const uint32_t covered_node, const uint32_t departure_node, const uint32_t arrival_node) const;
     [[nodiscard]] double get_UB(const uint32_t covered_node, const uint32_t departure_node, const uint32_t arrival_node) const;
+    [[nodiscard]] bool covers(const uint32_t covered_node, const uint32_t departure_node, const uint32_t arrival_node) const;
+    [[nodiscard]] std::span<const CoverWindow> covered_by(const uint32_t departure_node, const uint32_t arrival_node) const;
     [[nodiscard]] uint32_t cost(const uint32_t node_A, const uint32_t node_B) const;
+    // sem verificação de limites: nós devem existir na instância
+    [[nodiscard]] uint32_t cost_unchecked(const uint32_t node_A, const uint32_t node_B) const noexcept { return cost_matrix_.get(node_A, node_B); }
+    [[nodiscard]] std::span<const uint32_t> neighbours(const uint32_t node) const;
+    [[nodiscard]] bool is_neighbour(const uint32_t node, const uint32_t candidate) const;
+    [[nodiscard]] uint32_t n_neighbours() const noexcept;
+    [[nodiscard]] const SpatialGrid& spatial_index() const noexcept;
+    void nodes_within(const Coord& point, std::vector<uint32_t>& out) const;
+    void nodes_near_edge(const uint32_t departure_node, const uint32_t arrival_node, std::vector<uint32_t>& out) const;
+    void nearest_nodes(const Coord& point, const uint32_t k, std::vector<uint32_t>& out) const;
     [[nodiscard]] Coord coordinate(const uint32_t node) const;
     [[nodiscard]] uint32_t k() const noexcept;
     [[nodiscard]] uint32_t n() const noexcept;
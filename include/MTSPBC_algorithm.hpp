@@ -24,4 +24,4 @@ void seg_exchange();
 
 // ready to use local search
 void minimize_e_dist(MTSPBC& solution, const MTSPBCInstance& instance);
-void minimize_e_dist_2(MTSPBC& solution, const MTSPBCInstance& instance);
+void minimize_e_dist_2(MTSPBC& solution, const MTSPBCInstance& instance, const bool granular = false);
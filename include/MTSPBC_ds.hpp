@@ -4,6 +4,41 @@
 #include <cstdint>
 #include <cstddef>
 #include <utility>
+#include <vector>
+
+
+// variação de uma solução candidata em relação à atual, sem aplicar o movimento
+struct MoveDelta {
+    int64_t length;             // soma dos comprimentos das rotas
+    int64_t max_distance;       // maior separação entre veículos
+};
+
+
+// cópia do trecho [from, fim) de uma rota antes da primeira alteração numa transação
+struct TourCheckpoint {
+    uint32_t vehicle;
+    size_t from;
+    uint32_t obj;
+    bool complete;
+    std::vector<uint32_t> tour;
+    std::vector<uint32_t> events;
+};
+
+
+// maior separação de um par de veículos e o instante em que ocorre
+struct PairSeparation {
+    uint32_t value;
+    uint32_t e_time;
+};
+
+
+// maior separação em tempo contínuo, não só nos eventos
+struct ContinuousSeparation {
+    double value;
+    uint32_t e_time;            // instante do máximo, ou o fim do trecho que se aproxima dele
+    uint32_t vehicle_1;
+    uint32_t vehicle_2;
+};
 
 
 struct Edge {
@@ -5,16 +5,19 @@
 #include "MTSPBC_ds.hpp"
 #include <cstddef>
 #include <cstdint>
+#include <span>
 #include <vector>
 
 
 int orientation(const Coord& a, const Coord& b, const Coord& c);
 Coord partial_coordinate(const Coord& m, const Coord& n, const double& dt);
 double coord_norm(const Coord& coord);
+Coord position_at(const MTSPBC& solution, const uint32_t vehicle, const uint32_t e_time);
 Coord real_position(const MTSPBC& solution, const uint32_t moving_vehicle, const uint32_t last_e_mv, const uint32_t last_e_mv_i, const uint32_t e_time);
 uint32_t distance(const Nodes& a, const Nodes& b);
 uint32_t distance(const Coord& a, const Coord& b);
 uint32_t distance(const MTSPBC& solution, const uint32_t event_index, const uint32_t moving_vehicle);
 uint32_t distance(const MTSPBC& solution, const uint32_t event_index, const uint32_t moving_vehicle_1, const uint32_t moving_vehicle_2);
+uint32_t max_separation(std::vector<Coord>& points, std::vector<Coord>& hull);
 // double coord_norm(const Coord& coord);
-uint32_t unassign(const std::vector<uint32_t>& nodes, std::vector<size_t>& un_nodes);
+uint32_t unassign(std::span<const uint32_t> nodes, std::vector<size_t>& un_nodes);
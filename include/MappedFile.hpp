@@ -0,0 +1,28 @@
+#pragma once
+
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+
+
+// mapeamento somente leitura de um arquivo inteiro (mmap)
+class MappedFile {
+
+    private:
+
+    const std::byte* data_;
+    size_t size_;
+
+    public:
+
+    explicit MappedFile(const std::string& filepath);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    [[nodiscard]] const std::byte* data() const noexcept;
+    [[nodiscard]] size_t size() const noexcept;
+    [[nodiscard]] std::span<const std::byte> bytes() const noexcept;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+
+inline size_t worker_count() {
+    return std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+
+/**
+ * @brief Runs fn(worker, item) for every item in [0, n_items) on all cores.
+ * @details Items are handed out in blocks of grain through an atomic
+ * counter, so uneven items balance out. worker is in [0, worker_count())
+ * and can index per-thread buffers. Exceptions thrown by a worker are
+ * rethrown on the calling thread.
+ */
+template <typename Fn>
+void parallel_for(const size_t n_items, Fn&& fn, const size_t grain = 1) {
+    size_t n_workers { std::min(worker_count(), (n_items + grain - 1) / std::max<size_t>(grain, 1)) };
+    if (n_workers <= 1) {
+        for (size_t i { 0 }; i < n_items; i++) {
+            fn(size_t { 0 }, i);
+        }
+        return;
+    }
+    std::atomic<size_t> next { 0 };
+    std::vector<std::exception_ptr> errors(n_workers);
+    std::vector<std::thread> workers;
+    for (size_t w { 0 }; w < n_workers; w++) {
+        workers.emplace_back([&, w]() {
+            try {
+                for (size_t begin { next.fetch_add(grain) }; begin < n_items; begin = next.fetch_add(grain)) {
+                    size_t end { std::min(n_items, begin + grain) };
+                    for (size_t i { begin }; i < end; i++) {
+                        fn(w, i);
+                    }
+                }
+            } catch (...) {
+                errors[w] = std::current_exception();
+            }
+        });
+    }
+    for (auto& t : workers) {
+        t.join();
+    }
+    for (auto& e : errors) {
+        if (e) {
+            std::rethrow_exception(e);
+        }
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+
+class SegmentTree {
+
+    private:
+
+    // árvore implícita: folha i em capacity_ + i, filhos de p em 2p e 2p + 1
+    std::vector<uint32_t> max_;
+    std::vector<uint64_t> sum_;
+    size_t size_;
+    size_t capacity_;                           // potência de 2, folhas além de size_ valem 0
+
+    void pull_(const size_t p) noexcept;
+
+    public:
+
+    SegmentTree();
+
+    void assign(std::span<const uint32_t> values);
+    void assign_suffix(const size_t first, std::span<const uint32_t> values);
+    void set(const size_t i, const uint32_t value);
+    [[nodiscard]] uint32_t max(const size_t first, const size_t last) const;
+    [[nodiscard]] uint64_t sum(const size_t first, const size_t last) const;
+    [[nodiscard]] uint32_t at(const size_t i) const;
+    [[nodiscard]] size_t size() const noexcept;
+};
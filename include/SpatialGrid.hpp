@@ -0,0 +1,39 @@
+#pragma once
+
+
+#include "MTSPBC_ds.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+class SpatialGrid {
+
+    private:
+
+    double min_x_;
+    double min_y_;
+    double cell_size_;
+    uint32_t n_cols_;
+    uint32_t n_rows_;
+    std::vector<uint32_t> cell_offsets_;        // CSR offsets, cell c owns [offsets[c], offsets[c+1])
+    std::vector<uint32_t> cell_nodes_;          // nodes bucketed by cell, sorted by node inside a cell
+    std::vector<Coord> coordinates_;
+
+    [[nodiscard]] uint32_t col_(const double x) const noexcept;
+    [[nodiscard]] uint32_t row_(const double y) const noexcept;
+    [[nodiscard]] double cell_gap_(const Coord& point, const uint32_t col, const uint32_t row) const noexcept;
+
+    public:
+
+    SpatialGrid();
+    SpatialGrid(const std::vector<Coord>& coordinates, const double cell_size);
+
+    uint32_t segment_candidates(const Coord& a, const Coord& b, const double radius, std::vector<uint32_t>& out) const;
+    void within_radius(const Coord& point, const double radius, std::vector<uint32_t>& out) const;
+    void near_segment(const Coord& a, const Coord& b, const double radius, std::vector<uint32_t>& out) const;
+    void nearest(const Coord& point, const uint32_t k, std::vector<uint32_t>& out) const;
+    [[nodiscard]] double cell_size() const noexcept;
+    [[nodiscard]] uint32_t n() const noexcept;
+    [[nodiscard]] size_t n_cells() const noexcept;
+};
@@ -0,0 +1,142 @@
+#pragma once
+
+
+#include "CostMatrix.hpp"
+#include "CoverIndex.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+
+// cursor sobre uma linha de texto, lê campos separados por espaços com std::from_chars
+class LineReader {
+
+    private:
+
+    const char* it_;
+    const char* end_;
+
+    void skip_ws_() noexcept {
+        while (it_ != end_ && (*it_ == ' ' || *it_ == '\t' || *it_ == '\r')) {
+            it_++;
+        }
+    }
+
+    public:
+
+    explicit LineReader(std::string_view line) : it_(line.data()), end_(line.data() + line.size()) {}
+
+    template <typename T>
+    bool read(T& value) noexcept {
+        skip_ws_();
+        if (it_ != end_ && *it_ == '+') {
+            it_++;
+        }
+        auto [ptr, ec] { std::from_chars(it_, end_, value) };
+        if (ec != std::errc()) {
+            return false;
+        }
+        it_ = ptr;
+        return true;
+    }
+    [[nodiscard]] bool blank() noexcept {
+        skip_ws_();
+        return it_ == end_ || *it_ == '#';
+    }
+};
+
+
+// descarta comentários e a primeira linha de dados (cabeçalho)
+inline std::string_view skip_header_line(std::string_view text) {
+    while (!text.empty()) {
+        size_t nl { text.find('\n') };
+        LineReader reader(text.substr(0, nl));
+        text.remove_prefix((nl == std::string_view::npos) ? text.size() : nl + 1);
+        if (!reader.blank()) {
+            break;
+        }
+    }
+    return text;
+}
+
+
+// um bloco por núcleo, com no mínimo 1 MB por bloco
+inline size_t line_chunk_count(const size_t n_bytes) {
+    constexpr size_t min_chunk_bytes { 1 << 20 };
+    size_t hw { std::max<size_t>(1, std::thread::hardware_concurrency()) };
+    return std::clamp<size_t>(n_bytes / min_chunk_bytes, 1, hw);
+}
+
+
+/**
+ * @brief Runs a function over every line of a text block, in parallel.
+ * @details The block is split in about one chunk per core, each
+ * boundary moved forward to the next line start, and every chunk
+ * is handed to one thread. line_fn(chunk, line) is called for each
+ * line of a chunk, in order; chunk indexes follow file order, so
+ * per-chunk outputs can be concatenated. Exceptions thrown by a
+ * worker are rethrown on the calling thread.
+ * @return The number of chunks used.
+ */
+template <typename LineFn>
+size_t parallel_for_lines(std::string_view text, LineFn&& line_fn, size_t n_chunks = 0) {
+    if (n_chunks == 0) {
+        n_chunks = line_chunk_count(text.size());
+    }
+    std::vector<size_t> bounds { 0 };
+    for (size_t c { 1 }; c < n_chunks; c++) {
+        size_t cut { std::max(bounds.back(), text.size() * c / n_chunks) };
+        size_t nl { text.find('\n', cut) };
+        cut = (nl == std::string_view::npos) ? text.size() : nl + 1;
+        bounds.push_back(cut);
+    }
+    bounds.push_back(text.size());
+    n_chunks = bounds.size() - 1;
+
+    auto run_chunk { [&](const size_t c) {
+        std::string_view chunk { text.substr(bounds[c], bounds[c + 1] - bounds[c]) };
+        while (!chunk.empty()) {
+            size_t nl { chunk.find('\n') };
+            std::string_view line { chunk.substr(0, nl) };
+            line_fn(c, line);
+            chunk.remove_prefix((nl == std::string_view::npos) ? chunk.size() : nl + 1);
+        }
+    } };
+
+    if (n_chunks == 1) {
+        run_chunk(0);
+        return 1;
+    }
+    std::vector<std::exception_ptr> errors(n_chunks);
+    std::vector<std::thread> workers;
+    for (size_t c { 0 }; c < n_chunks; c++) {
+        workers.emplace_back([&, c]() {
+            try {
+                run_chunk(c);
+            } catch (...) {
+                errors[c] = std::current_exception();
+            }
+        });
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    for (auto& e : errors) {
+        if (e) {
+            std::rethrow_exception(e);
+        }
+    }
+    return n_chunks;
+}
+
+
+void parse_dist_file(const std::string& dist_filepath, CostMatrix& cost_matrix);
+std::vector<CoverTriple> parse_cover_file(const std::string& cover_filepath, const uint32_t n_nodes);
@@ -0,0 +1,39 @@
+#pragma once
+
+
+#include "MTSPBCInstance.hpp"
+#include "MTSPBC_ds.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+
+class Trajectories {
+
+    private:
+
+    // arestas de todos os veículos em SoA; o veículo v ocupa [offsets_[v], offsets_[v + 1])
+    std::vector<uint32_t> offsets_;
+    std::vector<uint32_t> start_time_;          // evento do nó de partida
+    std::vector<double> start_x_;
+    std::vector<double> start_y_;
+    std::vector<double> unit_x_;                // vetor unitário da aresta, zero após o último nó
+    std::vector<double> unit_y_;
+    // buffers do bloco em interpolate, reaproveitados entre chamadas
+    mutable std::vector<double> block_x_;
+    mutable std::vector<double> block_y_;
+    mutable std::vector<double> block_ux_;
+    mutable std::vector<double> block_uy_;
+    mutable std::vector<double> block_dt_;
+
+    public:
+
+    Trajectories();
+
+    void assign(const std::vector<std::span<const uint32_t>>& tours, const std::vector<std::span<const uint32_t>>& events,
+                const MTSPBCInstance& instance);
+    void interpolate(std::span<const uint32_t> times, std::span<uint32_t> cursor, double* xs, double* ys) const;
+    [[nodiscard]] ContinuousSeparation max_separation(const uint32_t vehicle_1, const uint32_t vehicle_2) const;
+    [[nodiscard]] uint32_t n_vehicles() const noexcept;
+};
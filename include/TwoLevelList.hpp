@@ -0,0 +1,49 @@
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+
+class TwoLevelList {
+
+    private:
+
+    struct Segment {
+        std::vector<uint32_t> nodes;
+        bool reversed;                          // nós lidos de trás para frente
+    };
+
+    std::vector<Segment> segments_;             // segmentos na ordem da rota, cada um com ~sqrt(n) nós
+    size_t size_;
+    size_t target_;                             // tamanho alvo de um segmento
+
+    [[nodiscard]] std::pair<size_t, size_t> locate_(const size_t pos) const;
+    [[nodiscard]] size_t physical_(const Segment& segment, const size_t offset) const noexcept;
+    size_t split_(const size_t pos);
+    void normalize_(Segment& segment);
+    void merge_small_(const size_t seg);
+    void rebuild_();
+
+    public:
+
+    TwoLevelList();
+    explicit TwoLevelList(std::span<const uint32_t> nodes);
+
+    void assign(std::span<const uint32_t> nodes);
+    void clear() noexcept;
+    void insert(const size_t pos, const uint32_t node);
+    void erase(const size_t pos);
+    void reverse(const size_t pos_i, const size_t pos_e);
+    void flatten(std::vector<uint32_t>& out) const;
+    void copy_range(const size_t pos_i, const size_t pos_e, std::vector<uint32_t>& out) const;
+    [[nodiscard]] uint32_t at(const size_t pos) const;
+    [[nodiscard]] uint32_t front() const;
+    [[nodiscard]] uint32_t back() const;
+    [[nodiscard]] size_t size() const noexcept;
+    [[nodiscard]] bool empty() const noexcept;
+    [[nodiscard]] size_t n_segments() const noexcept;
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 #include <string>
@@ -10,6 +11,7 @@
 uint32_t read_instance(std::string file_name, std::vector<Coord>& coord, uint32_t& k_vehicles_p, uint32_t& n_nodes_p, uint32_t& r_radius_p);           // read the instance from BCLIB
 std::vector<std::vector<uint32_t>> read_inst_dist(std::string input_file);         // read distance matrix from pre processing
 uint32_t read_cover(std::string cover_file);        // read the cover pre processing data
+bool covers_node(size_t i, size_t j, size_t k);          // checks if the edge (i, j) covers k
 std::vector<uint32_t> find_initial_hull();               // find the hull for one vehicle
 std::vector<std::vector<uint32_t>> find_onion_hull();    // find the hull for every vehicle
 std::vector<uint32_t> find_route();                      // find the route for one vehicle
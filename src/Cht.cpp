@@ -13,12 +13,14 @@
 
 
 #include "Cht.hpp"
+#include "TwoLevelList.hpp"
 #include <cstddef>
 #include <cstdint>
 #include <algorithm>
 #include <iterator>
 #include <limits>
 #include <optional>
+#include <span>
 #include <stdexcept>
 #include <utility>
 #include <vector>
@@ -31,6 +33,88 @@
 Cht::Cht(){
     obj_ = 0;
     complete_tour_ = false;
+    indexed_upto_ = 0;
+    backend_ = TourBackend::vector;
+    list_ahead_ = false;
+    list_behind_ = false;
+    flat_upto_ = 0;
+    instance_ = nullptr;
+}
+
+
+/**
+ * @brief Selects the tour representation.
+ * @details With TourBackend::two_level, middle insertions and
+ * removals and reversals go to a two-level list in O(sqrt(n))
+ * and the vector and the events are rebuilt only when they are
+ * read, once per batch of edits. Other edits, and the vector
+ * backend, work on the vector as before. Switching keeps the tour.
+ * @param backend The representation for the next edits.
+ */
+void Cht::set_backend(const TourBackend backend) {
+    materialize_();
+    backend_ = backend;
+    list_behind_ = true;
+    if (backend == TourBackend::vector) {
+        list_.clear();
+    }
+}
+
+
+[[nodiscard]] TourBackend Cht::get_backend() const noexcept { return backend_; }
+
+
+/**
+ * @brief Brings the vector and the events up to the list.
+ * @details Called by the readers of the whole tour or of the events.
+ * Flattens the list and sums the events again from the costs, O(n);
+ * a no-op unless list edits are pending. Point reads and the
+ * evaluate_* deltas go to the list instead, see node_at_().
+ */
+void Cht::materialize_() const {
+    if (!list_ahead_) {
+        return;
+    }
+    list_.flatten(tour_);
+    events_.resize(std::max<size_t>(tour_.size(), 1));
+    events_[0] = 0;
+    for (size_t i { 1 }; i < tour_.size(); i++) {
+        events_[i] = events_[i - 1] + instance_->cost_unchecked(tour_[i - 1], tour_[i]);
+    }
+    stale_from_(0);
+    list_ahead_ = false;
+}
+
+
+// nó em pos lido da lista em O(sqrt(n)) se ela está à frente, sem achatá-la
+[[nodiscard]] uint32_t Cht::node_at_(const size_t pos) const {
+    return list_ahead_ ? list_.at(pos) : tour_.at(pos);
+}
+
+
+// edições no vetor: traz o vetor em dia e marca a lista para ser refeita
+void Cht::use_vector_() {
+    materialize_();
+    list_behind_ = true;
+}
+
+
+// edições na lista: refaz a lista se o vetor foi alterado depois dela
+void Cht::use_list_(const MTSPBCInstance& instance) {
+    if (list_behind_) {
+        list_.assign(tour_);
+        list_behind_ = false;
+    }
+    if (!list_ahead_) {
+        flat_upto_ = tour_.size();
+    }
+    instance_ = &instance;
+    list_ahead_ = true;
+}
+
+
+void Cht::check_complete_listed_() noexcept {
+    complete_tour_ = list_.size() >= 3 && list_.front() == 0 && list_.back() == 0;
 }
 
 
@@ -46,6 +130,20 @@ Cht::Cht(){
  * @return Returns the updated objective value.
  */
 uint32_t Cht::insert_node(const uint32_t node, const size_t pos, const MTSPBCInstance& instance) {
+    if (node > instance.n() - 1) {
+        throw std::logic_error("error: node does not exist");
+    }
+    if (backend_ == TourBackend::two_level && pos > 0 && pos < n_nodes()) {
+        use_list_(instance);
+        const uint32_t node_A { list_.at(pos - 1) };
+        const uint32_t node_C { list_.at(pos) };
+        list_.insert(pos, node);
+        stale_from_(pos);
+        check_complete_listed_();
+        obj_ += instance.cost_unchecked(node_A, node) + instance.cost_unchecked(node, node_C) - instance.cost_unchecked(node_A, node_C);
+        return obj_;
+    }
+    use_vector_();
     if (tour_.size() - 1 < pos) {
         throw std::logic_error("insert node error: no such position");
         return 0;
@@ -58,7 +156,7 @@ uint32_t Cht::insert_node(const uint32_t node, const size_t pos, const MTSPBCIns
     } else {
         tour_.insert(it_pos, node);
         check_complete_tour_();
-        compute_events_(pos, instance);
+        insert_event_(pos, instance);
         if (tour_.front() == 0 && tour_.back() == 0) {
             complete_tour_ = true;
         } else complete_tour_ = false;
@@ -78,6 +176,18 @@ uint32_t Cht::insert_node(const uint32_t node, const size_t pos, const MTSPBCIns
  * @return Returns the updated objective value of the tour.
  */
 uint32_t Cht::remove_node(const size_t pos, const MTSPBCInstance& instance) {
+    if (backend_ == TourBackend::two_level && pos > 0 && pos + 1 < n_nodes()) {
+        use_list_(instance);
+        const uint32_t node_A { list_.at(pos - 1) };
+        const uint32_t node_B { list_.at(pos) };
+        const uint32_t node_C { list_.at(pos + 1) };
+        list_.erase(pos);
+        stale_from_(pos);
+        check_complete_listed_();
+        obj_ += instance.cost_unchecked(node_A, node_C) - instance.cost_unchecked(node_A, node_B) - instance.cost_unchecked(node_B, node_C);
+        return obj_;
+    }
+    use_vector_();
     if (tour_.size() - 1 < pos) {
         throw std::logic_error("remove node error: no such position");
         return obj_;
@@ -94,9 +204,10 @@ uint32_t Cht::remove_node(const size_t pos, const MTSPBCInstance& instance) {
         return pop_back(instance);
     } else {
         uint32_t new_obj { compute_obj_remove_(pos - 1, pos, pos + 1, instance) };
+        uint32_t removed_node { *it_pos };
         tour_.erase(it_pos);
         check_complete_tour_();
-        compute_events_(pos, instance);
+        remove_event_(pos, removed_node, instance);
         return new_obj;
     }
 }
@@ -118,30 +229,65 @@ uint32_t Cht::remove_node(const size_t pos, const MTSPBCInstance& instance) {
  * travel order.
  * @return The vector representing the tour.
  */
-[[nodiscard]]std::vector<uint32_t> Cht::get_tour() const noexcept { return tour_; }
+[[nodiscard]]std::vector<uint32_t> Cht::get_tour() const { materialize_(); return tour_; }
 
 
 /**
  * @brief Find the index of a given node in the tour.
  * @details This method finds the first ocurrence of
- * a given node in the tour. If a node is not in tour
- * throws an exception.
+ * a given node in the tour, or the last position for the
+ * depot when the tour ends at it. Lookups go through the
+ * node index, so they are O(1) once the positions changed
+ * by the last edits are reindexed.
  * @param node The node to be found.
- * @return The index of the found node.
+ * @return The index of the found node, if it is in the tour.
  */
 [[nodiscard]] std::optional<size_t> Cht::get_pos_for_node(const uint32_t node) const {
+    materialize_();
 
-    if (node == 0 && tour_.back() == 0) {
+    if (node == 0 && !tour_.empty() && tour_.back() == 0) {
         return tour_.size() - 1;
     }
 
-    auto it { std::find(tour_.begin(), tour_.end(), node) };
-
-    if (it == tour_.end()) {
-        return std::nullopt;
+    if (indexed_upto_ < tour_.size()) {
+        reindex_();
     }
+    if (node < node_pos_.size()) {
+        uint32_t pos { node_pos_[node] };
+        if (pos < std::min(indexed_upto_, tour_.size()) && tour_[pos] == node) {
+            return pos;
+        }
+    }
+    return std::nullopt;
+}
+
 
-    return std::distance(tour_.begin(), it);
+// edições a partir de pos invalidam o índice dali em diante, como os eventos e o vetor atrás da lista
+void Cht::stale_from_(const size_t pos) const noexcept {
+    indexed_upto_ = std::min(indexed_upto_, pos);
+    flat_upto_ = std::min(flat_upto_, pos);
+}
+
+
+/**
+ * @brief Brings the node index up to date.
+ * @details Positions before indexed_upto_ did not change since
+ * they were indexed, so an entry pointing there at the same node
+ * is still its first occurrence. Only the suffix from
+ * indexed_upto_ on is scanned, keeping earlier occurrences.
+ */
+void Cht::reindex_() const {
+    for (size_t q { indexed_upto_ }; q < tour_.size(); q++) {
+        uint32_t node { tour_[q] };
+        if (node >= node_pos_.size()) {
+            node_pos_.resize(node + 1, std::numeric_limits<uint32_t>::max());
+        }
+        uint32_t& pos { node_pos_[node] };
+        if (!(pos < q && tour_[pos] == node)) {
+            pos = static_cast<uint32_t>(q);
+        }
+    }
+    indexed_upto_ = tour_.size();
 }
 
 
@@ -154,10 +300,10 @@ uint32_t Cht::remove_node(const size_t pos, const MTSPBCInstance& instance) {
  * @return The node.
  */
 [[nodiscard]] uint32_t Cht::get_node_at_pos(const size_t pos) const {
-    if (tour_.size() - 1 < pos) {
+    if (n_nodes() - 1 < pos) {
         throw std::logic_error("empty tour_");
     }
-    return tour_.at(pos);
+    return node_at_(pos);
 }
 
 
@@ -175,9 +321,9 @@ uint32_t Cht::compute_obj_insert_(size_t pos_A, size_t pos_B, size_t pos_C, cons
     uint32_t node_A { tour_.at(pos_A) };
     uint32_t node_B { tour_.at(pos_B) };
     uint32_t node_C { tour_.at(pos_C) };
-    uint32_t broken_edge_obj { instance.cost(node_A, node_C) };
-    uint32_t add_edge_AB { instance.cost(node_A, node_B) };
-    uint32_t add_edge_BC { instance.cost(node_B, node_C) };
+    uint32_t broken_edge_obj { instance.cost_unchecked(node_A, node_C) };
+    uint32_t add_edge_AB { instance.cost_unchecked(node_A, node_B) };
+    uint32_t add_edge_BC { instance.cost_unchecked(node_B, node_C) };
     uint32_t diff_obj { add_edge_AB + add_edge_BC - broken_edge_obj };
     obj_ += diff_obj;
     return obj_;
@@ -199,12 +345,12 @@ uint32_t Cht::compute_obj_insert_(const bool at_end, const MTSPBCInstance& insta
     if (at_end) {
         uint32_t node_A { tour_.back() };
         uint32_t node_B { tour_.at(tour_.size() - 2) };
-        uint32_t additional_obj { instance.cost(node_A, node_B) };
+        uint32_t additional_obj { instance.cost_unchecked(node_A, node_B) };
         obj_ += additional_obj;
     } else {
         uint32_t node_A { tour_.front() };
         uint32_t node_B { tour_.at(1) };
-        uint32_t additional_obj { instance.cost(node_A, node_B) };
+        uint32_t additional_obj { instance.cost_unchecked(node_A, node_B) };
         obj_ += additional_obj;
     }
     return obj_;
@@ -218,14 +364,14 @@ uint32_t Cht::compute_obj_insert_(const uint32_t pos_i, const uint32_t pos_e, co
         if (i == pos_i) {
             continue;
         }
-        subtour_obj += instance.cost(tour_.at(last_i), tour_.at(i));
+        subtour_obj += instance.cost_unchecked(tour_.at(last_i), tour_.at(i));
         last_i = i;
     }
     if (pos_i != 0) {
-        subtour_obj += instance.cost(tour_.at(pos_i - 1), tour_.at(pos_i));
+        subtour_obj += instance.cost_unchecked(tour_.at(pos_i - 1), tour_.at(pos_i));
     }
     if (pos_e != tour_.size() - 1) {
-        subtour_obj += instance.cost(tour_.at(pos_e), tour_.at(pos_e + 1));
+        subtour_obj += instance.cost_unchecked(tour_.at(pos_e), tour_.at(pos_e + 1));
     }
     obj_ += subtour_obj;
     return obj_;
@@ -240,9 +386,9 @@ uint32_t Cht::compute_obj_remove_(size_t pos_A, size_t pos_B, size_t pos_C, cons
     uint32_t node_A { tour_.at(pos_A) };
     uint32_t node_B { tour_.at(pos_B) };
     uint32_t node_C { tour_.at(pos_C) };
-    uint32_t direct_edge_obj { instance.cost(node_A, node_C) };
-    uint32_t broken_edge_AB { instance.cost(node_A, node_B) };
-    uint32_t broken_edge_BC { instance.cost(node_B, node_C) };
+    uint32_t direct_edge_obj { instance.cost_unchecked(node_A, node_C) };
+    uint32_t broken_edge_AB { instance.cost_unchecked(node_A, node_B) };
+    uint32_t broken_edge_BC { instance.cost_unchecked(node_B, node_C) };
     int32_t diff_obj { static_cast<int32_t>(direct_edge_obj - broken_edge_AB - broken_edge_BC) };
     obj_ += diff_obj;
     return obj_;
@@ -255,11 +401,11 @@ uint32_t Cht::compute_obj_remove_(const bool at_end, const MTSPBCInstance& insta
     } else if (at_end == true) {
         uint32_t node_A { tour_.back() };
         uint32_t node_B { tour_.at(tour_.size() - 2) };
-        obj_ -= instance.cost(node_A, node_B);
+        obj_ -= instance.cost_unchecked(node_A, node_B);
     } else {
         uint32_t node_A { tour_.front() };
         uint32_t node_B { tour_.at(1) };
-        obj_ -= instance.cost(node_A, node_B);
+        obj_ -= instance.cost_unchecked(node_A, node_B);
     }
     return obj_;
 }
@@ -272,61 +418,106 @@ uint32_t Cht::compute_obj_remove_(const uint32_t pos_i, const uint32_t pos_e, co
         if (i == pos_i) {
             continue;
         }
-        obj_sub += instance.cost(tour_.at(i), tour_.at(last_i));
+        obj_sub += instance.cost_unchecked(tour_.at(i), tour_.at(last_i));
         last_i = i;
     }
     if (pos_i != 0) {
-        obj_sub += instance.cost(tour_.at(pos_i - 1), tour_.at(pos_i));
+        obj_sub += instance.cost_unchecked(tour_.at(pos_i - 1), tour_.at(pos_i));
     }
     if (pos_e != tour_.size() - 1) {
-        obj_sub += instance.cost(tour_.at(pos_e + 1), tour_.at(pos_e));
+        obj_sub += instance.cost_unchecked(tour_.at(pos_e + 1), tour_.at(pos_e));
     }
     obj_ -= obj_sub;
     return obj_;
 }
 
 
+// recalcula todos os eventos no próprio vetor; a rota vazia mantém o evento inicial 0
 uint32_t Cht::compute_events_(const MTSPBCInstance& instance) {
-    std::vector<uint32_t> new_events { 0 };
-    for (auto i{ 1 }; i < tour_.size(); i++) {
-        uint32_t curr_node { tour_.at(i) };
-        uint32_t prev_node { tour_.at(i - 1) };
-        uint32_t new_event_diff { instance.cost(prev_node, curr_node) };
-        new_events.push_back(new_event_diff + new_events.back());
-    }
-    events_ = new_events;
+    stale_from_(0);
+    events_.resize(std::max<size_t>(tour_.size(), 1));
+    events_[0] = 0;
+    for (size_t i { 1 }; i < tour_.size(); i++) {
+        events_[i] = events_[i - 1] + instance.cost_unchecked(tour_[i - 1], tour_[i]);
+    }
     return events_.back();
 }
 
 
+/**
+ * @brief Recomputes the events from a position on, in place.
+ * @details Events before inserted_pos are prefix sums of an
+ * unchanged prefix and are kept; the suffix is resized to the
+ * tour and rewritten without any temporary vector.
+ * @param inserted_pos First position whose event may have changed.
+ * @return The last event, i.e. the tour length.
+ */
 uint32_t Cht::compute_events_(const uint32_t inserted_pos, const MTSPBCInstance& instance) {
+    stale_from_(inserted_pos);
+    if (tour_.empty()) {
+        events_.clear();
+        return 0;
+    }
     if (inserted_pos > tour_.size() - 1) {
         throw std::logic_error("error: cannot compute events on out of range position");
     }
-    std::vector<uint32_t> new_events {  };
-    std::vector<uint32_t> old_events { events_ };
-    for (auto i{ inserted_pos }; i < tour_.size(); i++) {
-        if (inserted_pos == 0) {
-            compute_events_(instance);
-            return events_.back();
-        }
-        uint32_t curr_node { tour_.at(i) };
-        uint32_t prev_node { tour_.at(i - 1) };
-        uint32_t new_event_diff { instance.cost(prev_node, curr_node) };
-        if (i == inserted_pos) {
-            new_events.push_back(new_event_diff + events_.at(i - 1));
-        }
-        else {
-            new_events.push_back(new_event_diff + new_events.back());
-        }
+    if (inserted_pos == 0) {
+        return compute_events_(instance);
+    }
+    events_.resize(tour_.size());
+    for (size_t i { inserted_pos }; i < tour_.size(); i++) {
+        events_[i] = events_[i - 1] + instance.cost_unchecked(tour_[i - 1], tour_[i]);
     }
-    events_.erase(events_.begin() + inserted_pos, events_.end());
-    events_.insert(events_.end(), new_events.begin(), new_events.end());
     return events_.back();
 }
 
 
+/**
+ * @brief Updates the events after a node was inserted at pos.
+ * @details Every later event moves by the same amount, the cost
+ * of the detour through the new node, so the suffix is shifted by
+ * a constant instead of being summed again from the costs.
+ * @param pos Position of the inserted node, strictly inside the tour.
+ */
+void Cht::insert_event_(const size_t pos, const MTSPBCInstance& instance) {
+    stale_from_(pos);
+    const uint32_t prev { tour_[pos - 1] };
+    const uint32_t node { tour_[pos] };
+    const uint32_t next { tour_[pos + 1] };
+    // aritmética modular: o deslocamento pode ser "negativo" se a matriz não respeita a desigualdade triangular
+    const uint32_t delta { instance.cost_unchecked(prev, node) + instance.cost_unchecked(node, next) - instance.cost_unchecked(prev, next) };
+    events_.insert(events_.begin() + pos, events_[pos - 1] + instance.cost_unchecked(prev, node));
+    for (size_t i { pos + 1 }; i < events_.size(); i++) {
+        events_[i] += delta;
+    }
+}
+
+
+/**
+ * @brief Updates the events after the node at pos was removed.
+ * @details Inverse of insert_event_: the event of the removed
+ * node is erased and every later event moves back by the cost
+ * of the detour.
+ * @param pos Position the node was removed from, strictly inside the tour.
+ * @param node The removed node.
+ */
+void Cht::remove_event_(const size_t pos, const uint32_t node, const MTSPBCInstance& instance) {
+    stale_from_(pos);
+    const uint32_t prev { tour_[pos - 1] };
+    const uint32_t next { tour_[pos] };
+    const uint32_t delta { instance.cost_unchecked(prev, node) + instance.cost_unchecked(node, next) - instance.cost_unchecked(prev, next) };
+    events_.erase(events_.begin() + pos);
+    for (size_t i { pos }; i < events_.size(); i++) {
+        events_[i] -= delta;
+    }
+}
+
+
 uint32_t Cht::push_back(const uint32_t node, const MTSPBCInstance& instance) {
+    use_vector_();
+    if (node > instance.n() - 1) {
+        throw std::logic_error("error: node does not exist");
+    }
     tour_.push_back(node);
     size_t pos { tour_.size() - 1 };
     compute_events_(pos, instance);
@@ -344,6 +535,10 @@ uint32_t Cht::push_back(const uint32_t node, const MTSPBCInstance& instance) {
 
 
 uint32_t Cht::push_front(const uint32_t node, const MTSPBCInstance& instance) {
+    use_vector_();
+    if (node > instance.n() - 1) {
+        throw std::logic_error("error: node does not exist");
+    }
     if (tour_.size() == 0) {
         tour_.push_back(node);
         compute_events_(instance);
@@ -362,6 +557,7 @@ uint32_t Cht::push_front(const uint32_t node, const MTSPBCInstance& instance) {
 
 
 uint32_t Cht::pop_front(const MTSPBCInstance& instance) {
+    use_vector_();
     if (tour_.size() == 0) {
         throw std::logic_error("error: cannot remove node from empty tour");
         return std::numeric_limits<uint32_t>::max();
@@ -375,6 +571,7 @@ uint32_t Cht::pop_front(const MTSPBCInstance& instance) {
 
 
 uint32_t Cht::pop_back(const MTSPBCInstance& instance) {
+    use_vector_();
     if (tour_.size() == 0) {
         throw std::logic_error("cannot remove node: empty tour");
         return 0;
@@ -388,6 +585,12 @@ uint32_t Cht::pop_back(const MTSPBCInstance& instance) {
 
 
 uint32_t Cht::insert_subtour(const MTSPBCInstance& instance, const std::vector<uint32_t>& subtour_indices, const uint32_t pos_i, const uint32_t pos_e) {
+    use_vector_();
+    for (auto node : subtour_indices) {
+        if (node > instance.n() - 1) {
+            throw std::logic_error("error: node does not exist");
+        }
+    }
     if (pos_i > tour_.size() - 1 || pos_e > tour_.size() - 1 || pos_i >= pos_e) {
         throw std::logic_error("error: invlid range");
     }
@@ -401,6 +604,12 @@ uint32_t Cht::insert_subtour(const MTSPBCInstance& instance, const std::vector<u
 
 
 uint32_t Cht::replace_subtour(const MTSPBCInstance& instance, const std::vector<uint32_t>& subtour_indices, const uint32_t pos_i, const uint32_t pos_e) {
+    use_vector_();
+    for (auto node : subtour_indices) {
+        if (node > instance.n() - 1) {
+            throw std::logic_error("error: node does not exist");
+        }
+    }
     compute_obj_remove_(pos_i, pos_e, instance);
     tour_.erase(tour_.begin() + pos_i, tour_.begin() + pos_e);
     tour_.insert(tour_.begin() + pos_i, subtour_indices.begin(), subtour_indices.end());
@@ -412,6 +621,7 @@ uint32_t Cht::replace_subtour(const MTSPBCInstance& instance, const std::vector<
 
 
 uint32_t Cht::remove_subtour(const MTSPBCInstance& instance, const uint32_t pos_i, const uint32_t pos_e) {
+    use_vector_();
     compute_obj_remove_(pos_i, pos_e, instance);
     tour_.erase(tour_.begin() + pos_i, tour_.begin() + pos_e);
     compute_events_(pos_i, instance);
@@ -421,6 +631,13 @@ uint32_t Cht::remove_subtour(const MTSPBCInstance& instance, const uint32_t pos_
 
 
 uint32_t Cht::reverse_subtour(const MTSPBCInstance& instance, const uint32_t pos_i, const uint32_t pos_e) {
+    if (backend_ == TourBackend::two_level) {
+        use_list_(instance);
+        list_.reverse(pos_i, pos_e);
+        stale_from_(pos_i);
+        check_complete_listed_();
+        return obj_;
+    }
     std::reverse(tour_.begin() + pos_i, tour_.begin() + pos_e);
     compute_events_(pos_i, instance);
     check_complete_tour_();
@@ -429,6 +646,13 @@ uint32_t Cht::reverse_subtour(const MTSPBCInstance& instance, const uint32_t pos
 
 
 uint32_t Cht::reverse_tour(const MTSPBCInstance& instance) {
+    if (backend_ == TourBackend::two_level) {
+        use_list_(instance);
+        list_.reverse(0, list_.size());
+        stale_from_(0);
+        check_complete_listed_();
+        return 0;
+    }
     std::reverse(tour_.begin(), tour_.end());
     compute_events_(instance);
     check_complete_tour_();
@@ -436,7 +660,188 @@ uint32_t Cht::reverse_tour(const MTSPBCInstance& instance) {
 }
 
 
+/**
+ * @brief Restores the tour from a saved suffix.
+ * @details Positions before from are assumed unchanged since the
+ * suffix was saved, so only [from, end) is copied back; events
+ * are prefix sums and need no recomputation. List edits pending
+ * after from are dropped without flattening the list. Used by the
+ * MTSPBC transaction rollback.
+ * @param from First position of the saved suffix.
+ * @param tour Saved nodes from position from on.
+ * @param events Saved events from position from on.
+ * @param obj Saved objective value.
+ * @param complete Saved complete tour flag.
+ */
+void Cht::restore_suffix(const size_t from, std::span<const uint32_t> tour, std::span<const uint32_t> events, const uint32_t obj, const bool complete) {
+    if (list_ahead_ && from <= flat_upto_) {
+        // o vetor antes de from ainda é o salvo: descarta as edições da lista sem achatá-la
+        list_ahead_ = false;
+        list_behind_ = true;
+    }
+    use_vector_();
+    if (from > tour_.size() || from > events_.size()) {
+        throw std::logic_error("error: saved suffix does not match the tour");
+    }
+    stale_from_(from);
+    tour_.resize(from);
+    tour_.insert(tour_.end(), tour.begin(), tour.end());
+    events_.resize(from);
+    events_.insert(events_.end(), events.begin(), events.end());
+    obj_ = obj;
+    complete_tour_ = complete;
+}
+
+
+/**
+ * @brief Length change of inserting a node, without inserting it.
+ * @details Same positions as insert_node: the node goes before
+ * pos, and an empty tour takes it at any position.
+ * @return New tour length minus current tour length.
+ */
+[[nodiscard]] int64_t Cht::evaluate_insert(const uint32_t node, const size_t pos, const MTSPBCInstance& instance) const {
+    if (node > instance.n() - 1) {
+        throw std::logic_error("error: node does not exist");
+    }
+    const size_t n { n_nodes() };
+    if (n == 0) {
+        return 0;
+    }
+    if (pos > n - 1) {
+        throw std::logic_error("insert node error: no such position");
+    }
+    const uint32_t node_C { node_at_(pos) };
+    if (pos == 0) {
+        return instance.cost_unchecked(node, node_C);
+    }
+    const uint32_t node_A { node_at_(pos - 1) };
+    return static_cast<int64_t>(instance.cost_unchecked(node_A, node)) + instance.cost_unchecked(node, node_C)
+           - instance.cost_unchecked(node_A, node_C);
+}
+
+
+/**
+ * @brief Length change of removing the node at pos, without removing it.
+ * @return New tour length minus current tour length.
+ */
+[[nodiscard]] int64_t Cht::evaluate_remove(const size_t pos, const MTSPBCInstance& instance) const {
+    const size_t n { n_nodes() };
+    if (n == 0) {
+        throw std::logic_error("error: cannot remove node from empty tour");
+    }
+    if (pos > n - 1) {
+        throw std::logic_error("remove node error: no such position");
+    }
+    if (n == 1) {
+        return 0;
+    }
+    const uint32_t node_B { node_at_(pos) };
+    if (pos == 0) {
+        return -static_cast<int64_t>(instance.cost_unchecked(node_B, node_at_(1)));
+    }
+    const uint32_t node_A { node_at_(pos - 1) };
+    if (pos == n - 1) {
+        return -static_cast<int64_t>(instance.cost_unchecked(node_A, node_B));
+    }
+    const uint32_t node_C { node_at_(pos + 1) };
+    return static_cast<int64_t>(instance.cost_unchecked(node_A, node_C))
+           - instance.cost_unchecked(node_A, node_B) - instance.cost_unchecked(node_B, node_C);
+}
+
+
+/**
+ * @brief Length change of reversing [pos_i, pos_e), without reversing it.
+ * @details Same interval as reverse_subtour. The forward length of
+ * the segment comes from the event prefix sums; its reversed length
+ * is summed, so asymmetric costs are exact. With list edits pending
+ * the events are stale: the segment and its two neighbours are
+ * copied from the list in O(sqrt(n) + pos_e - pos_i) and summed
+ * both ways instead.
+ * @return New tour length minus current tour length.
+ */
+[[nodiscard]] int64_t Cht::evaluate_2opt(const uint32_t pos_i, const uint32_t pos_e, const MTSPBCInstance& instance) const {
+    const size_t n { n_nodes() };
+    if (pos_i > pos_e || pos_e > n) {
+        throw std::logic_error("error: invalid interval");
+    }
+    if (pos_e - pos_i < 2) {
+        return 0;
+    }
+    if (list_ahead_) {
+        // o trecho com os vizinhos, numa só busca na lista
+        const size_t lo { (pos_i > 0) ? pos_i - 1u : 0u };
+        list_.copy_range(lo, std::min<size_t>(n, pos_e + 1u), window_);
+        const std::vector<uint32_t>& w { window_ };
+        const size_t i { pos_i - lo };
+        const size_t e { pos_e - lo };
+        int64_t delta { 0 };
+        for (size_t q { i }; q + 1 < e; q++) {
+            delta += static_cast<int64_t>(instance.cost_unchecked(w[q + 1], w[q])) - instance.cost_unchecked(w[q], w[q + 1]);
+        }
+        if (pos_i > 0) {
+            delta += static_cast<int64_t>(instance.cost_unchecked(w[i - 1], w[e - 1])) - instance.cost_unchecked(w[i - 1], w[i]);
+        }
+        if (pos_e < n) {
+            delta += static_cast<int64_t>(instance.cost_unchecked(w[i], w[e])) - instance.cost_unchecked(w[e - 1], w[e]);
+        }
+        return delta;
+    }
+    int64_t delta { -static_cast<int64_t>(events_[pos_e - 1] - events_[pos_i]) };
+    for (uint32_t p { pos_i }; p + 1 < pos_e; p++) {
+        delta += instance.cost_unchecked(tour_[p + 1], tour_[p]);
+    }
+    if (pos_i > 0) {
+        delta += static_cast<int64_t>(instance.cost_unchecked(tour_[pos_i - 1], tour_[pos_e - 1])) - instance.cost_unchecked(tour_[pos_i - 1], tour_[pos_i]);
+    }
+    if (pos_e < n) {
+        delta += static_cast<int64_t>(instance.cost_unchecked(tour_[pos_i], tour_[pos_e])) - instance.cost_unchecked(tour_[pos_e - 1], tour_[pos_e]);
+    }
+    return delta;
+}
+
+
+/**
+ * @brief Length change of moving [pos_i, pos_e) before to_pos, without moving it.
+ * @details to_pos is a position of the tour without the segment,
+ * in [0, n - (pos_e - pos_i)]; the segment keeps its direction.
+ * @return New tour length minus current tour length.
+ */
+[[nodiscard]] int64_t Cht::evaluate_or_opt(const uint32_t pos_i, const uint32_t pos_e, const uint32_t to_pos, const MTSPBCInstance& instance) const {
+    const size_t n { n_nodes() };
+    if (pos_i >= pos_e || pos_e > n || to_pos > n - (pos_e - pos_i)) {
+        throw std::logic_error("error: invalid interval");
+    }
+    const uint32_t len { pos_e - pos_i };
+    const size_t m { n - len };
+    // nó q da rota sem o segmento
+    auto reduced { [&](const size_t q) { return (q < pos_i) ? node_at_(q) : node_at_(q + len); } };
+    const uint32_t first { node_at_(pos_i) };
+    const uint32_t last { node_at_(pos_e - 1) };
+    int64_t delta { 0 };
+    if (pos_i > 0) {
+        delta -= instance.cost_unchecked(node_at_(pos_i - 1), first);
+    }
+    if (pos_e < n) {
+        delta -= instance.cost_unchecked(last, node_at_(pos_e));
+    }
+    if (pos_i > 0 && pos_e < n) {
+        delta += instance.cost_unchecked(node_at_(pos_i - 1), node_at_(pos_e));
+    }
+    if (to_pos > 0 && to_pos < m) {
+        delta -= instance.cost_unchecked(reduced(to_pos - 1), reduced(to_pos));
+    }
+    if (to_pos > 0) {
+        delta += instance.cost_unchecked(reduced(to_pos - 1), first);
+    }
+    if (to_pos < m) {
+        delta += instance.cost_unchecked(last, reduced(to_pos));
+    }
+    return delta;
+}
+
+
 bool Cht::check_complete_tour_() {
+    materialize_();
     if (tour_.size() < 3) {
         complete_tour_ = false;
         return false;
@@ -450,28 +855,65 @@ bool Cht::check_complete_tour_() {
 }
 
 
-[[nodiscard]] size_t Cht::n_nodes() const noexcept { return tour_.size(); }
+[[nodiscard]] size_t Cht::n_nodes() const noexcept { return list_ahead_ ? list_.size() : tour_.size(); }
+
+
+// com a lista à frente, são os eventos que materialize_() faria, um por nó
+[[nodiscard]] uint32_t Cht::n_events() const { return list_ahead_ ? std::max<size_t>(list_.size(), 1) : events_.size(); }
 
 
-[[nodiscard]] uint32_t Cht::n_events() const noexcept { return events_.size(); }
+// prefixo [0, n) das visões; só achata a lista se alguma edição pendente cai nele
+[[nodiscard]] std::span<const uint32_t> Cht::tour_prefix(const size_t n) const {
+    if (list_ahead_ && n > flat_upto_) {
+        materialize_();
+    }
+    return std::span<const uint32_t>(tour_).first(std::min(n, tour_.size()));
+}
+[[nodiscard]] std::span<const uint32_t> Cht::events_prefix(const size_t n) const {
+    if (list_ahead_ && n > flat_upto_) {
+        materialize_();
+    }
+    return std::span<const uint32_t>(events_).first(std::min(n, events_.size()));
+}
 
 
-[[nodiscard]] std::vector<uint32_t> Cht::get_events() const noexcept { return events_;}
+[[nodiscard]] std::vector<uint32_t> Cht::get_events() const { materialize_(); return events_;}
 
 
 [[nodiscard]] bool Cht::get_complete() const noexcept { return complete_tour_; }
 
 
+// events_ é não decrescente: as consultas por tempo são buscas binárias
 [[nodiscard]] std::optional<uint32_t> Cht::get_node_at_event(const uint32_t e_time) const {
-    auto e_node { std::find(events_.begin(), events_.end(), e_time) };
-    if (e_node == events_.end()) {
+    materialize_();
+    auto e_node { std::lower_bound(events_.begin(), events_.end(), e_time) };
+    if (e_node == events_.end() || *e_node != e_time) {
         return std::nullopt;
     }
     return tour_.at(std::distance(events_.begin(), e_node));
 }
 
 
+/**
+ * @brief Position of the last event at or before a time.
+ * @details The vehicle is on the edge leaving this position at
+ * e_time, or at its last node once the tour is over. Binary
+ * search over the event times.
+ * @param e_time The time.
+ * @return The position, 0 before the first event.
+ */
+[[nodiscard]] size_t Cht::last_event_at(const uint32_t e_time) const {
+    materialize_();
+    if (events_.empty()) {
+        throw std::logic_error("error: empty tour");
+    }
+    auto it { std::upper_bound(events_.begin(), events_.end(), e_time) };
+    return (it == events_.begin()) ? 0 : std::distance(events_.begin(), it) - 1;
+}
+
+
 [[nodiscard]] Edge Cht::edge(const uint32_t edge_i) const {
+    materialize_();
     if (tour_.size() < 1) {
         throw std::logic_error("error: no edges");
     }
@@ -484,25 +926,29 @@ bool Cht::check_complete_tour_() {
 
 
 [[nodiscard]] Edge Cht::edge_at_event(const uint32_t e_time) const {
+    materialize_();
     if (events_.size() == 0) {
         throw std::logic_error("error: empty tour");
     }
     if (e_time > events_.back()) {
         return Edge(std::make_pair(tour_.size() - 2, tour_.at(tour_.size() - 2)), std::make_pair(tour_.size() - 1, tour_.back()));
     }
-    for (uint32_t i { 1 }; i < events_.size(); i++) {
-        if (events_.at(i) > e_time) {
-            return edge(i - 1);
-        }
+    auto it { std::upper_bound(events_.begin() + 1, events_.end(), e_time) };
+    if (it != events_.end()) {
+        return edge(std::distance(events_.begin(), it) - 1);
     }
     return edge(tour_.size() - 2);
 }
 
 
 [[nodiscard]] uint32_t Cht::event_index(const uint32_t e_time) const {
+    materialize_();
     if (e_time > events_.back()) {
         return events_.size() - 1;
     }
-    auto it { std::find(events_.begin(), events_.end(), e_time) };
+    auto it { std::lower_bound(events_.begin(), events_.end(), e_time) };
+    if (it != events_.end() && *it != e_time) {
+        return events_.size();
+    }
     return std::distance(events_.begin(), it);
 }
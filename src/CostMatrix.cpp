@@ -0,0 +1,92 @@
+/**
+ * @file CostMatrix.cpp
+ * @brief Compressed cost matrix storage
+ * @details A full 32-bit matrix is repacked in the smallest
+ * layout that keeps every entry: only the lower triangle when
+ * the matrix is symmetric, and 16-bit entries when the largest
+ * cost fits. get() reads every layout, so callers see the same
+ * costs.
+ */
+
+
+#include "CostMatrix.hpp"
+#include "Parallel.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+
+namespace {
+
+template <typename Entry>
+void pack_rows(const CostMatrix& full, CostMatrix& packed, Entry* out) {
+    const uint32_t n { full.n() };
+    const bool triangle { packed.layout() == CostLayout::triangle };
+    const size_t stride { packed.stride() };
+    parallel_for(n, [&](const size_t, const size_t a) {
+        Entry* row { out + (triangle ? a * (a + 1) / 2 : a * stride) };
+        const uint32_t end { triangle ? static_cast<uint32_t>(a) + 1 : n };
+        for (uint32_t b { 0 }; b < end; b++) {
+            row[b] = static_cast<Entry>(full.get(a, b));
+        }
+    }, 16);
+}
+
+}
+
+
+/**
+ * @brief Repacks a full 32-bit matrix in the smallest layout.
+ * @details Rows are checked in parallel for symmetry and for the
+ * largest cost. Matrices already compressed, or that cannot be
+ * compressed, are returned as they are (views stay views).
+ * @param matrix The matrix, consumed.
+ * @return The compressed matrix.
+ */
+CostMatrix CostMatrix::compress(CostMatrix&& matrix) {
+    if (matrix.layout_ != CostLayout::full || matrix.entry_bytes_ != sizeof(uint32_t) || matrix.n_nodes_ == 0) {
+        return std::move(matrix);
+    }
+    const uint32_t n { matrix.n_nodes_ };
+    std::atomic<bool> symmetric { true };
+    std::vector<uint32_t> row_max(n, 0);
+    parallel_for(n, [&](const size_t, const size_t a) {
+        uint32_t max_cost { 0 };
+        bool row_symmetric { true };
+        for (uint32_t b { 0 }; b < n; b++) {
+            uint32_t cost { matrix.get(a, b) };
+            max_cost = std::max(max_cost, cost);
+            row_symmetric &= (b >= a || cost == matrix.get(b, a));
+        }
+        row_max[a] = max_cost;
+        if (!row_symmetric) {
+            symmetric.store(false, std::memory_order_relaxed);
+        }
+    }, 16);
+    uint32_t max_cost { 0 };
+    for (uint32_t m : row_max) {
+        max_cost = std::max(max_cost, m);
+    }
+    const bool narrow { max_cost <= std::numeric_limits<uint16_t>::max() };
+    if (!symmetric && !narrow) {
+        return std::move(matrix);
+    }
+
+    CostMatrix packed;
+    packed.n_nodes_ = n;
+    packed.layout_ = symmetric ? CostLayout::triangle : CostLayout::full;
+    packed.entry_bytes_ = narrow ? sizeof(uint16_t) : sizeof(uint32_t);
+    packed.stride_ = (packed.layout_ == CostLayout::full) ? padded_stride(n) : 0;
+    packed.storage_.resize(block_bytes(n, packed.layout_, packed.entry_bytes_));
+    packed.data_ = packed.storage_.data();
+    packed.resolve_();
+    if (narrow) {
+        pack_rows(matrix, packed, reinterpret_cast<uint16_t*>(packed.storage_.data()));
+    } else {
+        pack_rows(matrix, packed, reinterpret_cast<uint32_t*>(packed.storage_.data()));
+    }
+    return packed;
+}
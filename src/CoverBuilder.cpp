@@ -0,0 +1,181 @@
+/**
+ * @file CoverBuilder.cpp
+ * @brief In-process cover computation
+ * @details Computes the cover windows of every (covered node,
+ * edge) pair from the coordinates and the radius, instead of
+ * reading them from cover.dat. A vehicle travelling from i to j
+ * covers node c while it is inside the disk of radius r around
+ * c; the window is the intersection of segment [i, j] with the
+ * disk, expressed in travel time along the edge, where the whole
+ * edge takes cost(i, j). Departure nodes are split across
+ * threads and a spatial grid prunes the nodes far from an edge.
+ */
+
+
+#include "CoverBuilder.hpp"
+#include "CostMatrix.hpp"
+#include "CoverIndex.hpp"
+#include "MTSPBC_ds.hpp"
+#include "Parallel.hpp"
+#include "SpatialGrid.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+
+namespace {
+
+void windows_scalar(const double* xs, const double* ys, const size_t begin, const size_t m, const Coord& a, const Coord& u, const double length, const double r_2, double* lo, double* hi) {
+    for (size_t i { begin }; i < m; i++) {
+        double fx { a.pos_x - xs[i] };
+        double fy { a.pos_y - ys[i] };
+        double b { fx * u.pos_x + fy * u.pos_y };
+        double c { fx * fx + fy * fy - r_2 };
+        double disc { b * b - c };
+        double s { std::sqrt(std::max(disc, 0.0)) };
+        lo[i] = std::max(0.0, -b - s) * (1.0 / length);
+        hi[i] = (disc < 0) ? -1.0 : std::min(length, -b + s) * (1.0 / length);
+    }
+}
+
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+void windows_avx2(const double* xs, const double* ys, const size_t m, const Coord& a, const Coord& u, const double length, const double r_2, double* lo, double* hi) {
+    const __m256d ax { _mm256_set1_pd(a.pos_x) };
+    const __m256d ay { _mm256_set1_pd(a.pos_y) };
+    const __m256d ux { _mm256_set1_pd(u.pos_x) };
+    const __m256d uy { _mm256_set1_pd(u.pos_y) };
+    const __m256d rr { _mm256_set1_pd(r_2) };
+    const __m256d len { _mm256_set1_pd(length) };
+    const __m256d inv_len { _mm256_set1_pd(1.0 / length) };
+    const __m256d zero { _mm256_setzero_pd() };
+    const __m256d minus_one { _mm256_set1_pd(-1.0) };
+    size_t i { 0 };
+    for (; i + 4 <= m; i += 4) {
+        __m256d fx { _mm256_sub_pd(ax, _mm256_loadu_pd(xs + i)) };
+        __m256d fy { _mm256_sub_pd(ay, _mm256_loadu_pd(ys + i)) };
+        // sem FMA: mesmos arredondamentos do laço escalar, qualquer que seja a posição do nó no lote
+        __m256d b { _mm256_add_pd(_mm256_mul_pd(fx, ux), _mm256_mul_pd(fy, uy)) };
+        __m256d c { _mm256_sub_pd(_mm256_add_pd(_mm256_mul_pd(fx, fx), _mm256_mul_pd(fy, fy)), rr) };
+        __m256d disc { _mm256_sub_pd(_mm256_mul_pd(b, b), c) };
+        __m256d s { _mm256_sqrt_pd(_mm256_max_pd(disc, zero)) };
+        __m256d nb { _mm256_sub_pd(zero, b) };
+        __m256d l { _mm256_mul_pd(_mm256_max_pd(zero, _mm256_sub_pd(nb, s)), inv_len) };
+        __m256d h { _mm256_mul_pd(_mm256_min_pd(len, _mm256_add_pd(nb, s)), inv_len) };
+        h = _mm256_blendv_pd(h, minus_one, _mm256_cmp_pd(disc, zero, _CMP_LT_OQ));
+        _mm256_storeu_pd(lo + i, l);
+        _mm256_storeu_pd(hi + i, h);
+    }
+    windows_scalar(xs, ys, i, m, a, u, length, r_2, lo, hi);
+}
+
+
+bool has_avx2() {
+    static const bool supported { __builtin_cpu_supports("avx2") != 0 };
+    return supported;
+}
+#endif
+
+}
+
+
+/**
+ * @brief Segment-disk intersection for a batch of nodes.
+ * @details For each node (xs[i], ys[i]) computes the part of segment
+ * [a, b] inside the disk of the given radius around the node, as
+ * fractions [lo[i], hi[i]] of the segment; hi[i] < lo[i] when the
+ * segment misses the disk. Coordinates are in SoA layout so the
+ * kernel runs 4 nodes per AVX2 instruction when the CPU supports
+ * it, with a scalar fallback.
+ */
+void segment_circle_windows(const double* xs, const double* ys, const size_t m, const Coord& a, const Coord& b, const double radius, double* lo, double* hi) {
+    Coord ab { b - a };
+    double length { std::sqrt(ab.pos_x * ab.pos_x + ab.pos_y * ab.pos_y) };
+    if (length == 0) {
+        for (size_t i { 0 }; i < m; i++) {
+            double dx { a.pos_x - xs[i] };
+            double dy { a.pos_y - ys[i] };
+            lo[i] = 0.0;
+            hi[i] = (dx * dx + dy * dy <= radius * radius) ? 1.0 : -1.0;
+        }
+        return;
+    }
+    Coord u { ab / length };
+#if defined(__x86_64__) || defined(__i386__)
+    if (has_avx2()) {
+        windows_avx2(xs, ys, m, a, u, length, radius * radius, lo, hi);
+        return;
+    }
+#endif
+    windows_scalar(xs, ys, 0, m, a, u, length, radius * radius, lo, hi);
+}
+
+
+/**
+ * @brief Builds the cover index of an instance.
+ * @details For every edge (i, j), i != j, the grid gives the nodes
+ * near the segment, the kernel gives their windows and the covering
+ * ones are kept, with the window scaled to [0, cost(i, j)].
+ * @param coordinates The node coordinates.
+ * @param cost_matrix The travel times of the edges.
+ * @param r_radius The cover radius.
+ * @return The cover index.
+ */
+CoverIndex build_cover(const std::vector<Coord>& coordinates, const CostMatrix& cost_matrix, const uint32_t r_radius) {
+    const uint32_t n { static_cast<uint32_t>(coordinates.size()) };
+    const double radius { static_cast<double>(r_radius) };
+    SpatialGrid grid(coordinates, std::max(radius, 1.0));
+    std::vector<std::vector<CoverTriple>> worker_triples(worker_count());
+
+    parallel_for(n, [&](const size_t worker, const size_t i) {
+        std::vector<uint32_t> candidates {};
+        std::vector<double> xs {};
+        std::vector<double> ys {};
+        std::vector<double> lo {};
+        std::vector<double> hi {};
+        auto& out { worker_triples[worker] };
+        const uint32_t departure { static_cast<uint32_t>(i) };
+        for (uint32_t arrival { 0 }; arrival < n; arrival++) {
+            if (arrival == departure) {
+                continue;
+            }
+            candidates.clear();
+            grid.segment_candidates(coordinates[departure], coordinates[arrival], radius, candidates);
+            size_t m { candidates.size() };
+            xs.resize(m);
+            ys.resize(m);
+            lo.resize(m);
+            hi.resize(m);
+            for (size_t c { 0 }; c < m; c++) {
+                xs[c] = coordinates[candidates[c]].pos_x;
+                ys[c] = coordinates[candidates[c]].pos_y;
+            }
+            segment_circle_windows(xs.data(), ys.data(), m, coordinates[departure], coordinates[arrival], radius, lo.data(), hi.data());
+            double travel_time { static_cast<double>(cost_matrix.get(departure, arrival)) };
+            for (size_t c { 0 }; c < m; c++) {
+                if (lo[c] <= hi[c]) {
+                    out.push_back(CoverTriple { candidates[c], departure, arrival, lo[c] * travel_time, hi[c] * travel_time });
+                }
+            }
+        }
+    });
+
+    size_t total { 0 };
+    for (const auto& t : worker_triples) {
+        total += t.size();
+    }
+    std::vector<CoverTriple> triples {};
+    triples.reserve(total);
+    for (auto& t : worker_triples) {
+        triples.insert(triples.end(), t.begin(), t.end());
+        std::vector<CoverTriple>().swap(t);
+    }
+    return CoverIndex(n, std::move(triples));
+}
@@ -0,0 +1,188 @@
+/**
+ * @file CoverIndex.cpp
+ * @brief Class CoverIndex implementation
+ * @details This file contains the implementation of the
+ * CoverIndex class. It stores, for every edge (i, j), the
+ * nodes covered by a vehicle travelling from i to j and
+ * the time window [LB, UB] in which the node is covered.
+ * Only covering triples (LB <= UB) are kept, in a CSR
+ * layout keyed by edge, so memory grows with the number
+ * of covering triples instead of n^3.
+ */
+
+
+#include "CoverIndex.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+
+/**
+ * @brief Constructor of the CoverIndex class.
+ * @details Initialize an empty index, where no edge covers
+ * any node.
+ */
+CoverIndex::CoverIndex()
+: n_nodes_(0), offsets_storage_(1, 0) {
+    attach_storage_();
+}
+
+
+/**
+ * @brief Builds the index from a list of cover triples.
+ * @details Triples that do not cover (UB < LB) are dropped.
+ * The remaining ones are bucketed by edge with a counting
+ * sort and each bucket is sorted by covered node, so a
+ * single (covered, departure, arrival) lookup is a binary
+ * search over the nodes covered by that edge.
+ * @param n_nodes Number of nodes of the instance (depot included).
+ * @param triples The cover triples, consumed by the index.
+ */
+CoverIndex::CoverIndex(const uint32_t n_nodes, std::vector<CoverTriple>&& triples)
+: n_nodes_(n_nodes), offsets_storage_(static_cast<size_t>(n_nodes) * n_nodes + 1, 0) {
+    std::vector<CoverTriple> input { std::move(triples) };
+    std::erase_if(input, [](const CoverTriple& t) { return t.UB < t.LB; });
+    for (const auto& t : input) {
+        if (t.covered_node >= n_nodes_ || t.departure_node >= n_nodes_ || t.arrival_node >= n_nodes_) {
+            throw std::out_of_range("error: cover triple references a node that does not exist");
+        }
+        offsets_storage_[static_cast<size_t>(t.departure_node) * n_nodes_ + t.arrival_node + 1]++;
+    }
+    for (size_t e { 1 }; e < offsets_storage_.size(); e++) {
+        offsets_storage_[e] += offsets_storage_[e - 1];
+    }
+    windows_storage_.resize(input.size());
+    std::vector<uint32_t> fill { offsets_storage_.begin(), offsets_storage_.end() - 1 };
+    for (const auto& t : input) {
+        size_t e { static_cast<size_t>(t.departure_node) * n_nodes_ + t.arrival_node };
+        windows_storage_[fill[e]++] = CoverWindow { t.covered_node, t.LB, t.UB };
+    }
+    for (size_t e { 0 }; e + 1 < offsets_storage_.size(); e++) {
+        std::sort(windows_storage_.begin() + offsets_storage_[e], windows_storage_.begin() + offsets_storage_[e + 1],
+            [](const CoverWindow& a, const CoverWindow& b) { return a.covered_node < b.covered_node; });
+    }
+    attach_storage_();
+}
+
+
+CoverIndex::CoverIndex(const CoverIndex& other)
+: n_nodes_(other.n_nodes_),
+offsets_storage_(other.offsets_storage_),
+windows_storage_(other.windows_storage_),
+edge_offsets_(other.edge_offsets_),
+windows_(other.windows_),
+owner_(other.owner_) {
+    if (!owner_) {
+        attach_storage_();
+    }
+}
+
+
+CoverIndex& CoverIndex::operator=(CoverIndex other) noexcept {
+    n_nodes_ = other.n_nodes_;
+    offsets_storage_ = std::move(other.offsets_storage_);
+    windows_storage_ = std::move(other.windows_storage_);
+    edge_offsets_ = other.edge_offsets_;
+    windows_ = other.windows_;
+    owner_ = std::move(other.owner_);
+    return *this;
+}
+
+
+/**
+ * @brief Index over an external block.
+ * @details Builds an index that reads offsets and windows
+ * directly from memory it does not own, such as a mapped
+ * binary instance cache. The owner is kept alive by the index.
+ * The cache checksum covers the source files, not the block, so
+ * the offsets are checked to start at 0, never decrease and end at
+ * windows.size(): every covered_by span then stays inside windows.
+ */
+CoverIndex CoverIndex::view(const uint32_t n_nodes, std::span<const uint32_t> edge_offsets, std::span<const CoverWindow> windows, std::shared_ptr<const void> owner) {
+    if (edge_offsets.size() != static_cast<size_t>(n_nodes) * n_nodes + 1 || edge_offsets.front() != 0 || edge_offsets.back() != windows.size()
+        || !std::is_sorted(edge_offsets.begin(), edge_offsets.end())) {
+        throw std::runtime_error("error: inconsistent cover index block");
+    }
+    CoverIndex index;
+    index.n_nodes_ = n_nodes;
+    index.offsets_storage_.clear();
+    index.edge_offsets_ = edge_offsets;
+    index.windows_ = windows;
+    index.owner_ = std::move(owner);
+    return index;
+}
+
+
+void CoverIndex::attach_storage_() {
+    edge_offsets_ = offsets_storage_;
+    windows_ = windows_storage_;
+}
+
+
+const CoverWindow* CoverIndex::find_(const uint32_t covered_node, const uint32_t departure_node, const uint32_t arrival_node) const {
+    auto windows { covered_by(departure_node, arrival_node) };
+    auto it { std::lower_bound(windows.begin(), windows.end(), covered_node,
+        [](const CoverWindow& w, const uint32_t node) { return w.covered_node < node; }) };
+    if (it == windows.end() || it->covered_node != covered_node) {
+        return nullptr;
+    }
+    return &(*it);
+}
+
+
+/**
+ * @brief Lower bound of the cover window.
+ * @details Returns +infinity when the edge does not cover
+ * the node, that is, when the triple has no window in the
+ * cover data, so that UB < LB means "not covered".
+ */
+[[nodiscard]] double CoverIndex::get_LB(const uint32_t covered_node, const uint32_t departure_node, const uint32_t arrival_node) const {
+    const CoverWindow* w { find_(covered_node, departure_node, arrival_node) };
+    return (w) ? w->LB : std::numeric_limits<double>::infinity();
+}
+
+
+/**
+ * @brief Upper bound of the cover window.
+ * @details Returns -infinity when the edge does not cover
+ * the node.
+ */
+[[nodiscard]] double CoverIndex::get_UB(const uint32_t covered_node, const uint32_t departure_node, const uint32_t arrival_node) const {
+    const CoverWindow* w { find_(covered_node, departure_node, arrival_node) };
+    return (w) ? w->UB : -std::numeric_limits<double>::infinity();
+}
+
+
+[[nodiscard]] bool CoverIndex::covers(const uint32_t covered_node, const uint32_t departure_node, const uint32_t arrival_node) const {
+    return find_(covered_node, departure_node, arrival_node) != nullptr;
+}
+
+
+/**
+ * @brief Nodes covered by an edge.
+ * @details Returns the cover windows of every node covered
+ * by a vehicle travelling from departure_node to
+ * arrival_node, sorted by covered node.
+ * @param departure_node The departing node of the edge.
+ * @param arrival_node The arrival node of the edge.
+ * @return A view over the windows, valid while the index lives.
+ */
+[[nodiscard]] std::span<const CoverWindow> CoverIndex::covered_by(const uint32_t departure_node, const uint32_t arrival_node) const {
+    if (departure_node >= n_nodes_ || arrival_node >= n_nodes_) {
+        throw std::out_of_range("error: node does not exist");
+    }
+    size_t e { static_cast<size_t>(departure_node) * n_nodes_ + arrival_node };
+    return std::span<const CoverWindow>(windows_.data() + edge_offsets_[e], edge_offsets_[e + 1] - edge_offsets_[e]);
+}
+
+
+[[nodiscard]] std::span<const uint32_t> CoverIndex::edge_offsets() const noexcept { return edge_offsets_; }
+[[nodiscard]] std::span<const CoverWindow> CoverIndex::windows() const noexcept { return windows_; }
+[[nodiscard]] size_t CoverIndex::n_windows() const noexcept { return windows_.size(); }
+[[nodiscard]] uint32_t CoverIndex::n() const noexcept { return n_nodes_; }
@@ -0,0 +1,147 @@
+/**
+ * @file DistanceBuilder.cpp
+ * @brief In-process distance matrix
+ * @details Computes the rounded Euclidean cost matrix from the
+ * coordinates instead of reading inst.dat. Every entry is
+ * bit-identical to distance(const Coord&, const Coord&):
+ * dx*dx + dy*dy without fused multiply-add, a correctly rounded
+ * sqrt and rounding half away from zero. Rows are split in
+ * blocks across threads.
+ */
+
+
+#include "DistanceBuilder.hpp"
+#include "CostMatrix.hpp"
+#include "MTSPBC_ds.hpp"
+#include "Parallel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+
+namespace {
+
+void distance_row_scalar(const double* xs, const double* ys, const size_t begin, const size_t m, const Coord& a, uint32_t* out) {
+    for (size_t j { begin }; j < m; j++) {
+        double dx { a.pos_x - xs[j] };
+        double dy { a.pos_y - ys[j] };
+        double dx_2 { dx * dx };
+        double dy_2 { dy * dy };
+        out[j] = static_cast<uint32_t>(std::round(std::sqrt(dx_2 + dy_2)));
+    }
+}
+
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+void distance_row_avx2(const double* xs, const double* ys, const size_t m, const Coord& a, uint32_t* out) {
+    const __m256d ax { _mm256_set1_pd(a.pos_x) };
+    const __m256d ay { _mm256_set1_pd(a.pos_y) };
+    const __m256d half { _mm256_set1_pd(0.5) };
+    const __m256d one { _mm256_set1_pd(1.0) };
+    size_t j { 0 };
+    for (; j + 4 <= m; j += 4) {
+        __m256d dx { _mm256_sub_pd(ax, _mm256_loadu_pd(xs + j)) };
+        __m256d dy { _mm256_sub_pd(ay, _mm256_loadu_pd(ys + j)) };
+        __m256d d { _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy))) };
+        // std::round: trunca e soma 1 se a parte fracionária (exata) for >= 0.5
+        __m256d t { _mm256_round_pd(d, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC) };
+        __m256d up { _mm256_and_pd(_mm256_cmp_pd(_mm256_sub_pd(d, t), half, _CMP_GE_OQ), one) };
+        __m128i r { _mm256_cvttpd_epi32(_mm256_add_pd(t, up)) };
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + j), r);
+    }
+    distance_row_scalar(xs, ys, j, m, a, out);
+}
+
+
+bool has_avx2() {
+    static const bool supported { __builtin_cpu_supports("avx2") != 0 };
+    return supported;
+}
+#endif
+
+}
+
+
+/**
+ * @brief Rounded distances from one point to a batch of points.
+ * @details Points are in SoA layout; 4 distances per instruction
+ * when the CPU supports AVX2, scalar otherwise.
+ */
+void distance_row(const double* xs, const double* ys, const size_t m, const Coord& a, uint32_t* out) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (has_avx2()) {
+        distance_row_avx2(xs, ys, m, a, out);
+        return;
+    }
+#endif
+    distance_row_scalar(xs, ys, 0, m, a, out);
+}
+
+
+/**
+ * @brief Builds the cost matrix of an instance.
+ * @param coordinates The node coordinates.
+ * @return The full n x n matrix of rounded Euclidean distances.
+ */
+CostMatrix build_cost_matrix(const std::vector<Coord>& coordinates) {
+    const uint32_t n { static_cast<uint32_t>(coordinates.size()) };
+    std::vector<double> xs(n);
+    std::vector<double> ys(n);
+    for (uint32_t i { 0 }; i < n; i++) {
+        xs[i] = coordinates[i].pos_x;
+        ys[i] = coordinates[i].pos_y;
+    }
+    CostMatrix cost_matrix(n);
+    uint32_t* rows { cost_matrix.mutable_data() };
+    const size_t stride { cost_matrix.stride() };
+    parallel_for(n, [&](const size_t, const size_t i) {
+        distance_row(xs.data(), ys.data(), n, coordinates[i], rows + i * stride);
+    }, 16);
+    return cost_matrix;
+}
+
+
+/**
+ * @brief Candidate lists of the nearest nodes.
+ * @details For every node, the n_neighbours other nodes with the
+ * smallest cost from it, closest first and ties broken by node
+ * index. Each row is a partial sort, rows are split across threads.
+ * @param cost_matrix The instance cost matrix.
+ * @param n_neighbours Length of every list, at most n - 1.
+ * @return The lists in one block, node i owns [i * n_neighbours, (i + 1) * n_neighbours).
+ */
+std::vector<uint32_t> build_neighbour_lists(const CostMatrix& cost_matrix, const uint32_t n_neighbours) {
+    const uint32_t n { cost_matrix.n() };
+    if (n_neighbours > 0 && n_neighbours >= n) {
+        throw std::logic_error("error: more neighbours than other nodes");
+    }
+    std::vector<uint32_t> neighbours(static_cast<size_t>(n) * n_neighbours);
+    if (n_neighbours == 0) {
+        return neighbours;
+    }
+    std::vector<std::vector<uint32_t>> buffers(worker_count());
+    parallel_for(n, [&](const size_t worker, const size_t i) {
+        std::vector<uint32_t>& others { buffers[worker] };
+        others.clear();
+        for (uint32_t j { 0 }; j < n; j++) {
+            if (j != i) {
+                others.push_back(j);
+            }
+        }
+        auto closer { [&cost_matrix, i](const uint32_t a, const uint32_t b) {
+            uint32_t cost_a { cost_matrix.get(i, a) };
+            uint32_t cost_b { cost_matrix.get(i, b) };
+            return (cost_a != cost_b) ? cost_a < cost_b : a < b;
+        } };
+        std::partial_sort(others.begin(), others.begin() + n_neighbours, others.end(), closer);
+        std::copy_n(others.begin(), n_neighbours, neighbours.begin() + i * n_neighbours);
+    }, 16);
+    return neighbours;
+}
@@ -0,0 +1,217 @@
+/**
+ * @file InstanceCache.cpp
+ * @brief Binary instance cache
+ * @details Compiled binary format for MTSPBC instances. The
+ * file holds a header, the coordinates, the cost matrix in
+ * its compressed layout and the CSR cover index, each section aligned to
+ * 64 bytes and laid out exactly like the in-memory
+ * structures, so opening a cache is a mmap plus header
+ * validation: cost matrix and cover index are views over
+ * the mapping. The header stores a checksum of the text
+ * files the cache was compiled from, to detect stale caches.
+ */
+
+
+#include "InstanceCache.hpp"
+#include "CostMatrix.hpp"
+#include "CoverIndex.hpp"
+#include "MappedFile.hpp"
+#include "MTSPBCInstance.hpp"
+#include "MTSPBC_ds.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+constexpr char cache_magic[8] { 'M', 'T', 'S', 'P', 'B', 'C', '\0', '\1' };
+constexpr uint32_t cache_version { 2 };
+constexpr uint64_t section_alignment { 64 };
+
+
+uint64_t align_up(const uint64_t offset) {
+    return ((offset + section_alignment - 1) / section_alignment) * section_alignment;
+}
+
+
+void write_padding(std::ofstream& out, const uint64_t target) {
+    static const char zeros[section_alignment] {};
+    uint64_t pos { static_cast<uint64_t>(out.tellp()) };
+    if (pos < target) {
+        out.write(zeros, static_cast<std::streamsize>(target - pos));
+    }
+}
+
+}
+
+
+/**
+ * @brief Checksum of the source text files.
+ * @details Hashes the files 8 bytes at a time over a read-only
+ * mapping, mixing in each file size. Hashing is memory bound,
+ * much cheaper than parsing the files.
+ * @param filepaths The files, in a fixed order.
+ * @return The checksum.
+ */
+uint64_t source_checksum(const std::vector<std::string>& filepaths) {
+    uint64_t h { 0xcbf29ce484222325ULL };
+    auto mix { [&h](const uint64_t word) {
+        h = (h ^ word) * 0x9e3779b97f4a7c15ULL;
+        h ^= h >> 32;
+    } };
+    for (const auto& path : filepaths) {
+        MappedFile file(path);
+        const std::byte* p { file.data() };
+        size_t n_words { file.size() / sizeof(uint64_t) };
+        for (size_t i { 0 }; i < n_words; i++) {
+            uint64_t word {};
+            std::memcpy(&word, p + i * sizeof(uint64_t), sizeof(uint64_t));
+            mix(word);
+        }
+        size_t n_tail { file.size() - n_words * sizeof(uint64_t) };
+        if (n_tail > 0) {
+            uint64_t tail {};
+            std::memcpy(&tail, p + n_words * sizeof(uint64_t), n_tail);
+            mix(tail);
+        }
+        mix(file.size());
+    }
+    return h;
+}
+
+
+/**
+ * @brief Reads the source checksum stored in a cache.
+ * @return The checksum, or nullopt if the file is missing
+ * or is not a cache of the current version.
+ */
+std::optional<uint64_t> read_cache_checksum(const std::string& cache_filepath) {
+    std::ifstream in(cache_filepath, std::ios::binary);
+    if (!in.is_open()) {
+        return std::nullopt;
+    }
+    InstanceCacheHeader header {};
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!in || std::memcmp(header.magic, cache_magic, sizeof(cache_magic)) != 0 || header.version != cache_version) {
+        return std::nullopt;
+    }
+    return header.source_checksum;
+}
+
+
+/**
+ * @brief Writes the binary cache of an instance.
+ * @details The file is written next to its final path and
+ * renamed at the end, so readers never see a partial cache.
+ * @param cache_filepath Path of the cache.
+ * @param data The instance.
+ * @param checksum Checksum of the source files (see source_checksum).
+ */
+void write_instance_cache(const std::string& cache_filepath, const InstanceData& data, const uint64_t checksum) {
+    const uint32_t n { data.n_nodes };
+    if (data.coordinates.size() != n || data.cost_matrix.n() != n || data.cover.n() != n) {
+        throw std::logic_error("error: inconsistent instance data");
+    }
+    InstanceCacheHeader header {};
+    std::memcpy(header.magic, cache_magic, sizeof(cache_magic));
+    header.version = cache_version;
+    header.header_size = sizeof(InstanceCacheHeader);
+    header.source_checksum = checksum;
+    header.k_vehicles = data.k_vehicles;
+    header.n_nodes = n;
+    header.r_radius = data.r_radius;
+    header.cover_window_size = sizeof(CoverWindow);
+    header.cost_stride = data.cost_matrix.stride();
+    header.cost_layout = static_cast<uint32_t>(data.cost_matrix.layout());
+    header.cost_entry_bytes = data.cost_matrix.entry_bytes();
+    header.n_cover_windows = data.cover.n_windows();
+    header.coord_offset = align_up(sizeof(InstanceCacheHeader));
+    header.cost_offset = align_up(header.coord_offset + n * sizeof(Coord));
+    header.cover_offsets_offset = align_up(header.cost_offset + data.cost_matrix.size_bytes());
+    header.cover_windows_offset = align_up(header.cover_offsets_offset + data.cover.edge_offsets().size_bytes());
+    header.file_size = header.cover_windows_offset + data.cover.windows().size_bytes();
+
+    std::string tmp_filepath { cache_filepath + ".tmp" };
+    std::ofstream out(tmp_filepath, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        throw std::runtime_error("error: could not create cache file " + cache_filepath);
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    write_padding(out, header.coord_offset);
+    out.write(reinterpret_cast<const char*>(data.coordinates.data()), static_cast<std::streamsize>(n * sizeof(Coord)));
+    write_padding(out, header.cost_offset);
+    out.write(reinterpret_cast<const char*>(data.cost_matrix.data()), static_cast<std::streamsize>(data.cost_matrix.size_bytes()));
+    write_padding(out, header.cover_offsets_offset);
+    out.write(reinterpret_cast<const char*>(data.cover.edge_offsets().data()), static_cast<std::streamsize>(data.cover.edge_offsets().size_bytes()));
+    write_padding(out, header.cover_windows_offset);
+    out.write(reinterpret_cast<const char*>(data.cover.windows().data()), static_cast<std::streamsize>(data.cover.windows().size_bytes()));
+    out.close();
+    if (!out) {
+        std::remove(tmp_filepath.c_str());
+        throw std::runtime_error("error: could not write cache file " + cache_filepath);
+    }
+    if (std::rename(tmp_filepath.c_str(), cache_filepath.c_str()) != 0) {
+        std::remove(tmp_filepath.c_str());
+        throw std::runtime_error("error: could not move cache file to " + cache_filepath);
+    }
+}
+
+
+/**
+ * @brief Opens a binary cache with mmap.
+ * @details Validates the header against the file size and
+ * returns instance data whose cost matrix and cover index
+ * read directly from the mapping; only the coordinates are
+ * copied. The mapping lives as long as those views.
+ * @param cache_filepath Path of the cache.
+ * @return The instance data.
+ */
+InstanceData open_instance_cache(const std::string& cache_filepath) {
+    auto file { std::make_shared<const MappedFile>(cache_filepath) };
+    if (file->size() < sizeof(InstanceCacheHeader)) {
+        throw std::runtime_error("error: cache file too small");
+    }
+    InstanceCacheHeader header {};
+    std::memcpy(&header, file->data(), sizeof(header));
+    if (std::memcmp(header.magic, cache_magic, sizeof(cache_magic)) != 0 || header.version != cache_version) {
+        throw std::runtime_error("error: not an instance cache of this version");
+    }
+    const uint64_t n { header.n_nodes };
+    const CostLayout layout { static_cast<CostLayout>(header.cost_layout) };
+    if (header.header_size != sizeof(InstanceCacheHeader)
+        || header.cover_window_size != sizeof(CoverWindow)
+        || (layout != CostLayout::full && layout != CostLayout::triangle)
+        || (header.cost_entry_bytes != sizeof(uint32_t) && header.cost_entry_bytes != sizeof(uint16_t))
+        || header.cost_stride != ((layout == CostLayout::full) ? CostMatrix::padded_stride(header.n_nodes) : 0)
+        || header.file_size != file->size()
+        || header.coord_offset + n * sizeof(Coord) > header.cost_offset
+        || header.cost_offset + CostMatrix::block_bytes(header.n_nodes, layout, header.cost_entry_bytes) > header.cover_offsets_offset
+        || header.cover_offsets_offset + (n * n + 1) * sizeof(uint32_t) > header.cover_windows_offset
+        || header.cover_windows_offset + header.n_cover_windows * sizeof(CoverWindow) > file->size()
+        || header.cost_offset % section_alignment != 0
+        || header.cover_windows_offset % alignof(CoverWindow) != 0) {
+        throw std::runtime_error("error: corrupted instance cache");
+    }
+
+    const std::byte* base { file->data() };
+    InstanceData data;
+    data.k_vehicles = header.k_vehicles;
+    data.n_nodes = header.n_nodes;
+    data.r_radius = header.r_radius;
+    data.coordinates.resize(n);
+    std::memcpy(data.coordinates.data(), base + header.coord_offset, n * sizeof(Coord));
+    data.cost_matrix = CostMatrix::view(header.n_nodes, layout, header.cost_entry_bytes, base + header.cost_offset, file);
+    std::span<const uint32_t> offsets { reinterpret_cast<const uint32_t*>(base + header.cover_offsets_offset), static_cast<size_t>(n * n + 1) };
+    std::span<const CoverWindow> windows { reinterpret_cast<const CoverWindow*>(base + header.cover_windows_offset), static_cast<size_t>(header.n_cover_windows) };
+    data.cover = CoverIndex::view(header.n_nodes, offsets, windows, file);
+    return data;
+}
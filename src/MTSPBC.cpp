@@ -4,8 +4,10 @@
 #include "MTSPBC_util.hpp"
 #include <cstdint>
 #include <optional>
+#include <span>
 #include <stdexcept>
 #include <algorithm>
+#include <array>
 #include <utility>
 #include <vector>
 #include <fstream>
@@ -20,6 +22,21 @@ MTSPBC::MTSPBC(const MTSPBCInstance& instance)
     k_vehicles_ = 0;
     r_radius_ = 0;
     feasible_ = false;
+    max_distance_value_ = 0;
+    dirty_ = false;
+    in_transaction_ = false;
+    journal_size_ = 0;
+    saved_total_obj_ = 0;
+    saved_feasible_ = false;
+    timeline_saved_ = false;
+    saved_max_distance_ = 0;
+    backend_ = TourBackend::vector;
+    pair_k_ = 0;
+    distances_from_ = 0;
+    saved_distances_from_ = 0;
+    pairs_dirty_ = false;
+    saved_pair_k_ = 0;
+    saved_pairs_dirty_ = false;
 }
 
 
@@ -27,9 +44,18 @@ MTSPBC::MTSPBC(const MTSPBCInstance& instance)
 
 // create vehicle, returns total vehicles
 uint32_t MTSPBC::create_vehicle() {
+    if (in_transaction_) {
+        throw std::logic_error("error: cannot create vehicles inside a transaction");
+    }
     Cht new_vehicle;
+    new_vehicle.set_backend(backend_);
     tours_.push_back(new_vehicle);
     k_vehicles_ = tours_.size();
+    dirty_vehicles_.resize(k_vehicles_, 0);
+    dirty_from_.resize(k_vehicles_, clean_from_);
+    // os pares mudam de índice: a próxima sincronização refaz pair_max_
+    dirty_ = true;
+    distances_from_ = 0;
     return k_vehicles_;
 }
 
@@ -38,32 +64,246 @@ uint32_t MTSPBC::remove_vehicle(const uint32_t vehicle_index) {
     if (k_vehicles_ - 1 < vehicle_index) {
         throw std::logic_error("error: vehicle not found");
     }
+    if (in_transaction_) {
+        throw std::logic_error("error: cannot remove vehicles inside a transaction");
+    }
     auto erase_it { tours_.begin() + vehicle_index };
     tours_.erase(erase_it);
     k_vehicles_ = tours_.size();
+    // os índices dos veículos seguintes mudam: refaz toda a linha do tempo
+    events_.clear();
+    dirty_vehicles_.assign(k_vehicles_, 1);
+    dirty_from_.assign(k_vehicles_, 0);
+    dirty_ = true;
+    distances_from_ = 0;
     return k_vehicles_;
 }
 
 
+/**
+ * @brief Selects the tour representation of every vehicle.
+ * @details TourBackend::two_level suits long tours edited by many
+ * insertions, removals and reversals between reads; see
+ * Cht::set_backend. Vehicles created later use it too.
+ * @param backend The representation.
+ */
+void MTSPBC::set_tour_backend(const TourBackend backend) {
+    backend_ = backend;
+    for (auto& tour : tours_) {
+        tour.set_backend(backend);
+    }
+}
+
+
 uint32_t MTSPBC::set_radius(const uint32_t r_radius) {
     r_radius_ = r_radius;
     return r_radius;
 }
 
 
-uint32_t MTSPBC::collect_events_() {
-    events_.clear();
-    for (uint32_t t { 0 }; t < tours_.size(); t++) {
-        std::vector<uint32_t> tour_e { tours_.at(t).get_events() };
-        std::vector<std::pair<uint32_t, uint32_t>> tour_e_pair {  };
-        for (uint32_t i { 0 }; i < tour_e.size(); i++) {
-            tour_e_pair.push_back(std::make_pair(tour_e.at(i), t));
+/**
+ * @brief Marks a vehicle as changed from a tour position on.
+ * @details The timeline and the distances are rebuilt once, on the
+ * next read. The vehicle is unchanged before the event of the node
+ * preceding first_pos, and so is every separation before that time:
+ * only the events from there on are swept again. Only the position
+ * is kept here; sync_() reads its event time once the tour is
+ * materialized, so a two-level tour is not flattened per mutation.
+ * @param vehicle The changed vehicle.
+ * @param first_pos First position the mutation may have changed.
+ */
+void MTSPBC::mark_dirty_(const uint32_t vehicle, const size_t first_pos) {
+    dirty_vehicles_.at(vehicle) = 1;
+    dirty_ = true;
+    dirty_from_[vehicle] = std::min(dirty_from_[vehicle], first_pos);
+}
+
+
+/**
+ * @brief Brings the timeline up to date.
+ * @details Events of the vehicles changed since the last call are
+ * replaced and merged into the sorted timeline in linear time, once,
+ * however many mutations were made in between. The changed vehicles
+ * are only added to changed_vehicles_: the distances and the pair
+ * cache are refreshed by their own readers.
+ */
+void MTSPBC::sync_() const {
+    if (!dirty_) {
+        return;
+    }
+    // primeira sincronização da transação: guarda a linha do tempo do begin() para o rollback
+    if (in_transaction_ && !timeline_saved_) {
+        saved_events_.assign(events_.begin(), events_.end());
+        saved_distances_.assign(max_distance_events_.begin(), max_distance_events_.end());
+        saved_tree_ = distance_tree_;
+        timeline_saved_ = true;
+    }
+    changed_vehicles_.resize(k_vehicles_, 0);
+    std::erase_if(events_, [this](const std::pair<uint32_t, uint32_t>& e) {
+        return e.second >= dirty_vehicles_.size() || dirty_vehicles_[e.second] != 0;
+    });
+    size_t n_kept { events_.size() };
+    for (uint32_t k { 0 }; k < k_vehicles_; k++) {
+        if (dirty_vehicles_[k] == 0) {
+            continue;
+        }
+        std::span<const uint32_t> events { tours_[k].events_view() };
+        for (uint32_t e_time : events) {
+            events_.emplace_back(e_time, k);
         }
-        events_.insert(events_.end(), tour_e_pair.begin(), tour_e_pair.end());
+        // as posições antes de dirty_from_ não mudaram, nem o tempo dos seus eventos
+        const size_t edge { std::min(dirty_from_[k], events.size()) };
+        distances_from_ = std::min(distances_from_, (edge == 0) ? 0 : events[edge - 1]);
+        changed_vehicles_[k] = 1;
+        dirty_vehicles_[k] = 0;
+        dirty_from_[k] = clean_from_;
     }
-    std::sort(events_.begin(), events_.end());
-    compute_max_distances_();
-    return events_.size();
+    std::sort(events_.begin() + n_kept, events_.end());
+    std::inplace_merge(events_.begin(), events_.begin() + n_kept, events_.end());
+    pairs_dirty_ = true;
+    dirty_ = false;
+}
+
+
+// refaz o cache dos pares só para quem o lê: get_max_distance, pair_separation e commit
+void MTSPBC::sync_pairs_() const {
+    sync_();
+    if (pairs_dirty_ || pair_k_ != k_vehicles_) {
+        update_pairs_();
+        pairs_dirty_ = false;
+    }
+}
+
+
+/**
+ * @brief Saves the part of a tour a mutation is about to change.
+ * @details Called by the wrappers before every mutation while a
+ * transaction is open. The first call for a vehicle copies its
+ * tour and events from first_pos on; a later call at an earlier
+ * position prepends the missing positions, which are still as at
+ * begin() since every change so far was after them. Neither call
+ * flattens a two-level tour: begin() left it flat, and the later
+ * one reads only the prefix the pending list edits did not touch.
+ * @param vehicle The vehicle about to change.
+ * @param first_pos First position the mutation may change.
+ */
+void MTSPBC::checkpoint_(const uint32_t vehicle, const size_t first_pos) {
+    if (!in_transaction_) {
+        return;
+    }
+    const Cht& cht { tours_.at(vehicle) };
+    uint32_t& slot { journal_slot_[vehicle] };
+    if (slot == no_slot_) {
+        std::span<const uint32_t> tour { cht.tour_view() };
+        std::span<const uint32_t> events { cht.events_view() };
+        const size_t from { std::min({ first_pos, tour.size(), events.size() }) };
+        if (journal_size_ == journal_.size()) {
+            journal_.emplace_back();
+        }
+        slot = journal_size_++;
+        TourCheckpoint& entry { journal_[slot] };
+        entry.vehicle = vehicle;
+        entry.from = from;
+        entry.obj = cht.get_obj();
+        entry.complete = cht.get_complete();
+        entry.tour.assign(tour.begin() + from, tour.end());
+        entry.events.assign(events.begin() + from, events.end());
+        return;
+    }
+    TourCheckpoint& entry { journal_[slot] };
+    const size_t from { std::min(first_pos, cht.n_nodes()) };
+    if (from < entry.from) {
+        std::span<const uint32_t> tour { cht.tour_prefix(entry.from) };
+        std::span<const uint32_t> events { cht.events_prefix(entry.from) };
+        entry.tour.insert(entry.tour.begin(), tour.begin() + from, tour.begin() + entry.from);
+        entry.events.insert(entry.events.begin(), events.begin() + from, events.begin() + entry.from);
+        entry.from = from;
+    }
+}
+
+
+/**
+ * @brief Opens a transaction.
+ * @details Brings the timeline up to date and starts journaling:
+ * until commit() or rollback(), every mutation first saves the
+ * tour range it changes. Vehicles cannot be created or removed
+ * inside a transaction.
+ */
+void MTSPBC::begin() {
+    if (in_transaction_) {
+        throw std::logic_error("error: transaction already open");
+    }
+    sync_();
+    journal_slot_.assign(k_vehicles_, no_slot_);
+    journal_size_ = 0;
+    saved_total_obj_ = total_obj_;
+    saved_feasible_ = feasible_;
+    saved_distances_from_ = distances_from_;
+    // o cache dos pares pode ser refeito na transação sem a linha do tempo mudar
+    saved_max_distance_ = max_distance_value_;
+    saved_changed_vehicles_.assign(changed_vehicles_.begin(), changed_vehicles_.end());
+    saved_pair_k_ = pair_k_;
+    saved_pairs_dirty_ = pairs_dirty_;
+    saved_pairs_.clear();
+    timeline_saved_ = false;
+    in_transaction_ = true;
+}
+
+
+// aplica as alterações pendentes e fecha a transação aberta, se houver; retorna a maior distância
+uint32_t MTSPBC::commit() {
+    sync_pairs_();
+    if (in_transaction_) {
+        for (size_t j { 0 }; j < journal_size_; j++) {
+            journal_slot_[journal_[j].vehicle] = no_slot_;
+        }
+        journal_size_ = 0;
+        timeline_saved_ = false;
+        in_transaction_ = false;
+    }
+    return max_distance_value_;
+}
+
+
+/**
+ * @brief Undoes every mutation since begin().
+ * @details The saved tour ranges, objective values, timeline and
+ * distances are copied back; nothing is recomputed, so a rejected
+ * move costs a copy of what it touched.
+ */
+void MTSPBC::rollback() {
+    if (!in_transaction_) {
+        throw std::logic_error("error: no open transaction");
+    }
+    for (size_t j { 0 }; j < journal_size_; j++) {
+        const TourCheckpoint& entry { journal_[j] };
+        tours_[entry.vehicle].restore_suffix(entry.from, entry.tour, entry.events, entry.obj, entry.complete);
+        journal_slot_[entry.vehicle] = no_slot_;
+    }
+    journal_size_ = 0;
+    total_obj_ = saved_total_obj_;
+    feasible_ = saved_feasible_;
+    if (timeline_saved_) {
+        events_.swap(saved_events_);
+        max_distance_events_.swap(saved_distances_);
+        std::swap(distance_tree_, saved_tree_);
+        distances_from_ = saved_distances_from_;
+    }
+    // do fim para o começo: a entrada guardada mais antiga é a do begin()
+    for (auto it { saved_pairs_.rbegin() }; it != saved_pairs_.rend(); it++) {
+        pair_max_[it->first] = it->second;
+    }
+    saved_pairs_.clear();
+    max_distance_value_ = saved_max_distance_;
+    changed_vehicles_.swap(saved_changed_vehicles_);
+    pair_k_ = saved_pair_k_;
+    pairs_dirty_ = saved_pairs_dirty_;
+    // begin() deixou a linha do tempo sincronizada
+    std::fill(dirty_vehicles_.begin(), dirty_vehicles_.end(), 0);
+    std::fill(dirty_from_.begin(), dirty_from_.end(), clean_from_);
+    dirty_ = false;
+    timeline_saved_ = false;
+    in_transaction_ = false;
 }
 
 
@@ -83,30 +323,395 @@ uint32_t MTSPBC::compute_obj_() {
 }
 
 
-uint32_t MTSPBC::compute_max_distances_() {
-    max_distance_events_.clear();
-    for (uint32_t i { 0 }; i < events_.size(); i++) {
-        // auto e_vehicle { events_.at(i).second };
+/**
+ * @brief Maximum separation between vehicles over a timeline.
+ * @details Sweeps the timeline in time order with one cursor per
+ * vehicle on its last event at or before the current time, so each
+ * vehicle position is interpolated once per event instead of once
+ * per pair. The vehicle of the event is at the node of the event.
+ * Gives the same values as distance(*this, i, k, l) over every pair;
+ * from calipers_min_vehicles_ vehicles on, the largest separation at
+ * an event comes from max_separation instead of every pair.
+ * @param timeline Sorted (time, vehicle) events.
+ * @param tours Node sequence of every vehicle.
+ * @param events Event times of every vehicle.
+ * @param per_event If not null, receives the separation at every event.
+ * @param first First event swept; per_event keeps the ones before it.
+ * @return The maximum separation from first on.
+ */
+uint32_t MTSPBC::sweep_(const std::vector<std::pair<uint32_t, uint32_t>>& timeline, const std::vector<std::span<const uint32_t>>& tours,
+                        const std::vector<std::span<const uint32_t>>& events, std::vector<uint32_t>* per_event, const size_t first) const {
+    if (per_event) {
+        per_event->resize(timeline.size());
+    }
+    trajectories_.assign(tours, events, instance_);
+    sweep_cursor_.assign(k_vehicles_, 0);
+    uint32_t max_distance { 0 };
+    for (size_t i { first }; i < timeline.size(); i++) {
+        const size_t q { (i - first) % block_events_ };
+        if (q == 0) {
+            block_times_.resize(std::min<size_t>(block_events_, timeline.size() - i));
+            for (size_t r { 0 }; r < block_times_.size(); r++) {
+                block_times_[r] = timeline[i + r].first;
+            }
+            interpolate_block_(block_times_);
+        }
+        const auto [e_time, e_vehicle] = timeline[i];
+        load_positions_(q, e_vehicle, e_time, tours, events);
         uint32_t curr_distance { 0 };
-        for (uint32_t k { 0 }; k < k_vehicles_ - 1; k++) {
-            for (uint32_t l { k + 1 }; l < k_vehicles_; l++) {
-                if (tours_.at(l).get_tour().size() < 2 || tours_.at(k).get_tour().size() < 2) {
+        if (k_vehicles_ >= calipers_min_vehicles_) {
+            sweep_points_.clear();
+            for (uint32_t k { 0 }; k < k_vehicles_; k++) {
+                if (tours[k].size() >= 2) {
+                    sweep_points_.push_back(sweep_position_[k]);
+                }
+            }
+            curr_distance = max_separation(sweep_points_, sweep_hull_);
+        } else {
+            for (uint32_t k { 0 }; k + 1 < k_vehicles_; k++) {
+                if (tours[k].size() < 2) {
                     continue;
                 }
-                uint32_t tmp_distance { distance(*this, i, k, l) };
-                if (tmp_distance > curr_distance) {
-                    curr_distance = tmp_distance;
+                for (uint32_t l { k + 1 }; l < k_vehicles_; l++) {
+                    if (tours[l].size() < 2) {
+                        continue;
+                    }
+                    curr_distance = std::max(curr_distance, distance(sweep_position_[k], sweep_position_[l]));
+                }
+            }
+        }
+        if (per_event) {
+            (*per_event)[i] = curr_distance;
+        }
+        max_distance = std::max(max_distance, curr_distance);
+    }
+    return max_distance;
+}
+
+
+// posições de todos os veículos num bloco de tempos não decrescentes, continuando de sweep_cursor_
+void MTSPBC::interpolate_block_(std::span<const uint32_t> times) const {
+    block_x_.resize(times.size() * k_vehicles_);
+    block_y_.resize(times.size() * k_vehicles_);
+    trajectories_.interpolate(times, sweep_cursor_, block_x_.data(), block_y_.data());
+}
+
+
+/**
+ * @brief Positions of the vehicles at one event of the block.
+ * @details Interpolated positions from interpolate_block_, except
+ * the vehicle of the event, which is at the node of its first event
+ * with that time, as in get_node_at_event.
+ * @param q Index of the event in the block.
+ */
+void MTSPBC::load_positions_(const size_t q, const uint32_t e_vehicle, const uint32_t e_time,
+                             const std::vector<std::span<const uint32_t>>& tours, const std::vector<std::span<const uint32_t>>& events) const {
+    sweep_position_.resize(k_vehicles_);
+    for (uint32_t k { 0 }; k < k_vehicles_; k++) {
+        sweep_position_[k] = { block_x_[q * k_vehicles_ + k], block_y_[q * k_vehicles_ + k] };
+    }
+    if (tours[e_vehicle].size() >= 2) {
+        std::span<const uint32_t> e_events { events[e_vehicle] };
+        size_t first { static_cast<size_t>(std::lower_bound(e_events.begin(), e_events.end(), e_time) - e_events.begin()) };
+        sweep_position_[e_vehicle] = instance_.coordinate(tours[e_vehicle][first]);
+    }
+}
+
+
+// índice do par k < l entre os k_vehicles_ * (k_vehicles_ - 1) / 2 pares
+[[nodiscard]] size_t MTSPBC::pair_index_(const uint32_t k, const uint32_t l) const noexcept {
+    return static_cast<size_t>(k) * (2 * k_vehicles_ - k - 1) / 2 + (l - k - 1);
+}
+
+
+/**
+ * @brief Updates the per-pair separations and the max distance.
+ * @details The separation of a pair at an event depends only on
+ * the two tours and on the event time, so the entry of pair (k, l)
+ * at the events of vehicle m changes only if k, l or m changed. At
+ * the events of a changed vehicle every pair is evaluated; at the
+ * events of the others, only the pairs with a changed vehicle.
+ * Positions follow sweep_, so the maximum is the same as a full
+ * sweep, in O(T k) per changed vehicle instead of O(T k^2). Inside
+ * a transaction, the entries about to be rewritten are journaled in
+ * saved_pairs_ for rollback().
+ */
+void MTSPBC::update_pairs_() const {
+    const uint32_t n_k { k_vehicles_ };
+    if (pair_k_ != n_k) {
+        pair_max_.assign(static_cast<size_t>(n_k) * (n_k - 1) / 2 * n_k, { 0, 0 });
+        pair_k_ = n_k;
+        changed_vehicles_.assign(n_k, 1);
+    }
+    std::vector<uint32_t> changed;
+    for (uint32_t k { 0 }; k < n_k; k++) {
+        if (changed_vehicles_[k] != 0) {
+            changed.push_back(k);
+        }
+    }
+    sweep_tours_.resize(n_k);
+    sweep_events_.resize(n_k);
+    for (uint32_t k { 0 }; k < n_k; k++) {
+        sweep_tours_[k] = tours_[k].tour_view();
+        sweep_events_[k] = tours_[k].events_view();
+    }
+    trajectories_.assign(sweep_tours_, sweep_events_, instance_);
+    auto update { [&](const uint32_t k, const uint32_t l, const uint32_t m, const uint32_t e_time) {
+        if (sweep_tours_[k].size() < 2 || sweep_tours_[l].size() < 2) {
+            return;
+        }
+        PairSeparation& entry { pair_max_[pair_index_(std::min(k, l), std::max(k, l)) * n_k + m] };
+        uint32_t d { distance(sweep_position_[k], sweep_position_[l]) };
+        if (d > entry.value) {
+            entry = { d, e_time };
+        }
+    } };
+
+    for (uint32_t m { 0 }; m < n_k && !changed.empty(); m++) {
+        const bool m_changed { changed_vehicles_[m] != 0 };
+        for (uint32_t k { 0 }; k + 1 < n_k; k++) {
+            for (uint32_t l { k + 1 }; l < n_k; l++) {
+                if (m_changed || changed_vehicles_[k] != 0 || changed_vehicles_[l] != 0) {
+                    const size_t i { pair_index_(k, l) * n_k + m };
+                    if (in_transaction_) {
+                        saved_pairs_.emplace_back(i, pair_max_[i]);
+                    }
+                    pair_max_[i] = { 0, 0 };
+                }
+            }
+        }
+        std::span<const uint32_t> m_events { sweep_events_[m] };
+        sweep_cursor_.assign(n_k, 0);
+        for (size_t q { 0 }; q < m_events.size(); q++) {
+            const uint32_t e_time { m_events[q] };
+            if (q % block_events_ == 0) {
+                interpolate_block_(m_events.subspan(q, std::min<size_t>(block_events_, m_events.size() - q)));
+            }
+            load_positions_(q % block_events_, m, e_time, sweep_tours_, sweep_events_);
+            if (m_changed) {
+                for (uint32_t k { 0 }; k + 1 < n_k; k++) {
+                    for (uint32_t l { k + 1 }; l < n_k; l++) {
+                        update(k, l, m, e_time);
+                    }
+                }
+                continue;
+            }
+            // só os pares com um veículo alterado; um par com dois alterados é visto pelo menor
+            for (uint32_t d : changed) {
+                for (uint32_t l { 0 }; l < n_k; l++) {
+                    if (l != d && (changed_vehicles_[l] == 0 || l > d)) {
+                        update(d, l, m, e_time);
+                    }
                 }
             }
         }
-        max_distance_events_.push_back(curr_distance);
     }
-    auto max_value { std::max_element(max_distance_events_.begin(), max_distance_events_.end()) };
-    max_distance_value_ = (max_value != max_distance_events_.end()) ? *max_value : 0;
+
+    max_distance_value_ = 0;
+    for (uint32_t k { 0 }; k + 1 < n_k; k++) {
+        for (uint32_t l { k + 1 }; l < n_k; l++) {
+            max_distance_value_ = std::max(max_distance_value_, pair_separation_unchecked_(k, l).value);
+        }
+    }
+    std::fill(changed_vehicles_.begin(), changed_vehicles_.end(), 0);
+}
+
+
+// refaz a separação nos eventos alterados da linha do tempo, só quando alguém a lê
+void MTSPBC::sync_distances_() const {
+    sync_();
+    if (distances_from_ != distances_synced_) {
+        compute_max_distances_(distances_from_);
+        distances_from_ = distances_synced_;
+    }
+}
+
+
+/**
+ * @brief Sweeps the timeline again from a time on.
+ * @details Events before from_time are the same as at the last
+ * sweep, at the same indices and with the same separation, so only
+ * the suffix is swept and replaced in distance_tree_.
+ * @param from_time Earliest time a vehicle changed since the last sweep.
+ */
+uint32_t MTSPBC::compute_max_distances_(const uint32_t from_time) const {
+    sweep_tours_.resize(k_vehicles_);
+    sweep_events_.resize(k_vehicles_);
+    for (uint32_t k { 0 }; k < k_vehicles_; k++) {
+        sweep_tours_[k] = tours_[k].tour_view();
+        sweep_events_[k] = tours_[k].events_view();
+    }
+    const size_t first { static_cast<size_t>(std::lower_bound(events_.begin(), events_.end(), std::make_pair(from_time, 0u)) - events_.begin()) };
+    sweep_(events_, sweep_tours_, sweep_events_, &max_distance_events_, first);
+    distance_tree_.assign_suffix(first, std::span<const uint32_t>(max_distance_events_).subspan(first));
     return 0;
 }
 
 
+/**
+ * @brief Scores the candidate tours in eval_tours_, without applying them.
+ * @details eval_tours_[j] replaces the tour of vehicles[j]. Events of
+ * a candidate are copied from the current prefix sums up to its first
+ * changed position and summed from there. Events before the earliest
+ * changed time are the same as in the current timeline, at the same
+ * indices and with the same separation, so their max comes from
+ * distance_tree_ and only the suffix is merged and swept.
+ * @param n_changed Number of candidate tours (1 or 2).
+ * @return Change in total tour length and in max separation.
+ */
+MoveDelta MTSPBC::evaluate_candidates_(const uint32_t n_changed, const std::array<uint32_t, 2>& vehicles, const std::array<size_t, 2>& first_changed) const {
+    sync_distances_();
+    MoveDelta delta { 0, 0 };
+    uint32_t from_time { UINT32_MAX };
+    for (uint32_t j { 0 }; j < n_changed; j++) {
+        std::span<const uint32_t> old_events { tours_[vehicles[j]].events_view() };
+        const std::vector<uint32_t>& tour { eval_tours_[j] };
+        std::vector<uint32_t>& cand_events { eval_events_[j] };
+        size_t keep { std::min({ first_changed[j], old_events.size(), tour.size() }) };
+        cand_events.assign(old_events.begin(), old_events.begin() + keep);
+        for (size_t q { keep }; q < tour.size(); q++) {
+            cand_events.push_back((q == 0) ? 0 : cand_events[q - 1] + instance_.cost_unchecked(tour[q - 1], tour[q]));
+        }
+        delta.length += static_cast<int64_t>(cand_events.empty() ? 0 : cand_events.back()) - (old_events.empty() ? 0 : old_events.back());
+        from_time = std::min(from_time, (keep == 0) ? 0 : cand_events[keep - 1]);
+    }
+
+    // só o sufixo a partir de from_time muda: mescla os eventos candidatos nele
+    auto changed { [&](const uint32_t k) { return vehicles[0] == k || (n_changed > 1 && vehicles[1] == k); } };
+    const size_t first { static_cast<size_t>(std::lower_bound(events_.begin(), events_.end(), std::make_pair(from_time, 0u)) - events_.begin()) };
+    eval_timeline_.clear();
+    for (size_t i { first }; i < events_.size(); i++) {
+        if (!changed(events_[i].second)) {
+            eval_timeline_.push_back(events_[i]);
+        }
+    }
+    size_t n_kept { eval_timeline_.size() };
+    sweep_tours_.resize(k_vehicles_);
+    sweep_events_.resize(k_vehicles_);
+    for (uint32_t k { 0 }; k < k_vehicles_; k++) {
+        sweep_tours_[k] = tours_[k].tour_view();
+        sweep_events_[k] = tours_[k].events_view();
+    }
+    for (uint32_t j { 0 }; j < n_changed; j++) {
+        const std::vector<uint32_t>& cand_events { eval_events_[j] };
+        for (auto it { std::lower_bound(cand_events.begin(), cand_events.end(), from_time) }; it != cand_events.end(); it++) {
+            eval_timeline_.emplace_back(*it, vehicles[j]);
+        }
+        sweep_tours_[vehicles[j]] = eval_tours_[j];
+        sweep_events_[vehicles[j]] = cand_events;
+    }
+    std::sort(eval_timeline_.begin() + n_kept, eval_timeline_.end());
+    std::inplace_merge(eval_timeline_.begin(), eval_timeline_.begin() + n_kept, eval_timeline_.end());
+    const uint32_t prefix_max { distance_tree_.max(0, first) };
+    const uint32_t suffix_max { sweep_(eval_timeline_, sweep_tours_, sweep_events_, nullptr, 0) };
+    delta.max_distance = static_cast<int64_t>(std::max(prefix_max, suffix_max)) - distance_tree_.max(0, distance_tree_.size());
+    return delta;
+}
+
+
+// variação de inserir node antes de pos (como insert_node)
+[[nodiscard]] MoveDelta MTSPBC::evaluate_insert(const uint32_t vehicle, const uint32_t node, const size_t pos) const {
+    if (k_vehicles_ - 1 < vehicle) {
+        throw std::logic_error("error: vehicles do not exist");
+    }
+    const Cht& tour { tours_[vehicle] };
+    (void)tour.evaluate_insert(node, pos, instance_);           // valida nó e posição
+    eval_tours_[0].assign(tour.tour_view().begin(), tour.tour_view().end());
+    eval_tours_[0].insert(eval_tours_[0].begin() + std::min(pos, eval_tours_[0].size()), node);
+    return evaluate_candidates_(1, { vehicle, 0 }, { pos, 0 });
+}
+
+
+// variação de remover o nó em pos (como remove_node)
+[[nodiscard]] MoveDelta MTSPBC::evaluate_remove(const uint32_t vehicle, const size_t pos) const {
+    if (k_vehicles_ - 1 < vehicle) {
+        throw std::logic_error("error: vehicle do not exist");
+    }
+    const Cht& tour { tours_[vehicle] };
+    (void)tour.evaluate_remove(pos, instance_);
+    eval_tours_[0].assign(tour.tour_view().begin(), tour.tour_view().end());
+    eval_tours_[0].erase(eval_tours_[0].begin() + pos);
+    return evaluate_candidates_(1, { vehicle, 0 }, { pos, 0 });
+}
+
+
+// variação de remove_node(from_vehicle, from_pos) seguido de insert_node(to_vehicle, nó, to_pos)
+[[nodiscard]] MoveDelta MTSPBC::evaluate_relocate(const uint32_t from_vehicle, const size_t from_pos, const uint32_t to_vehicle, const size_t to_pos) const {
+    if (k_vehicles_ - 1 < from_vehicle || k_vehicles_ - 1 < to_vehicle) {
+        throw std::logic_error("error: vehicle do not exist");
+    }
+    std::span<const uint32_t> from_tour { tours_[from_vehicle].tour_view() };
+    (void)tours_[from_vehicle].evaluate_remove(from_pos, instance_);
+    const uint32_t node { from_tour[from_pos] };
+    eval_tours_[0].assign(from_tour.begin(), from_tour.end());
+    eval_tours_[0].erase(eval_tours_[0].begin() + from_pos);
+    std::vector<uint32_t>& to_tour { (from_vehicle == to_vehicle) ? eval_tours_[0] : eval_tours_[1] };
+    if (from_vehicle != to_vehicle) {
+        to_tour.assign(tours_[to_vehicle].tour_view().begin(), tours_[to_vehicle].tour_view().end());
+    }
+    if (!to_tour.empty() && to_pos > to_tour.size() - 1) {
+        throw std::logic_error("insert node error: no such position");
+    }
+    to_tour.insert(to_tour.begin() + std::min(to_pos, to_tour.size()), node);
+    if (from_vehicle == to_vehicle) {
+        return evaluate_candidates_(1, { from_vehicle, 0 }, { std::min(from_pos, to_pos), 0 });
+    }
+    return evaluate_candidates_(2, { from_vehicle, to_vehicle }, { from_pos, to_pos });
+}
+
+
+// variação de trocar os nós em (vehicle_1, pos_1) e (vehicle_2, pos_2)
+[[nodiscard]] MoveDelta MTSPBC::evaluate_swap(const uint32_t vehicle_1, const size_t pos_1, const uint32_t vehicle_2, const size_t pos_2) const {
+    if (k_vehicles_ - 1 < vehicle_1 || k_vehicles_ - 1 < vehicle_2) {
+        throw std::logic_error("error: vehicle do not exist");
+    }
+    std::span<const uint32_t> tour_1 { tours_[vehicle_1].tour_view() };
+    std::span<const uint32_t> tour_2 { tours_[vehicle_2].tour_view() };
+    if (pos_1 >= tour_1.size() || pos_2 >= tour_2.size()) {
+        throw std::logic_error("error: no such position");
+    }
+    eval_tours_[0].assign(tour_1.begin(), tour_1.end());
+    if (vehicle_1 == vehicle_2) {
+        std::swap(eval_tours_[0][pos_1], eval_tours_[0][pos_2]);
+        return evaluate_candidates_(1, { vehicle_1, 0 }, { std::min(pos_1, pos_2), 0 });
+    }
+    eval_tours_[1].assign(tour_2.begin(), tour_2.end());
+    std::swap(eval_tours_[0][pos_1], eval_tours_[1][pos_2]);
+    return evaluate_candidates_(2, { vehicle_1, vehicle_2 }, { pos_1, pos_2 });
+}
+
+
+// variação de reverse_subtour(vehicle, pos_i, pos_e): inverte [pos_i, pos_e)
+[[nodiscard]] MoveDelta MTSPBC::evaluate_2opt(const uint32_t vehicle, const uint32_t pos_i, const uint32_t pos_e) const {
+    if (k_vehicles_ - 1 < vehicle) {
+        throw std::logic_error("error: vehicle does not exist");
+    }
+    const Cht& tour { tours_[vehicle] };
+    if (pos_i > pos_e || pos_e > tour.n_nodes() - 1) {
+        throw std::logic_error("error: invalid interval");
+    }
+    eval_tours_[0].assign(tour.tour_view().begin(), tour.tour_view().end());
+    std::reverse(eval_tours_[0].begin() + pos_i, eval_tours_[0].begin() + pos_e);
+    return evaluate_candidates_(1, { vehicle, 0 }, { pos_i, 0 });
+}
+
+
+// variação de mover o segmento [pos_i, pos_e) para antes de to_pos da rota sem o segmento
+[[nodiscard]] MoveDelta MTSPBC::evaluate_or_opt(const uint32_t vehicle, const uint32_t pos_i, const uint32_t pos_e, const uint32_t to_pos) const {
+    if (k_vehicles_ - 1 < vehicle) {
+        throw std::logic_error("error: vehicle does not exist");
+    }
+    const Cht& tour { tours_[vehicle] };
+    (void)tour.evaluate_or_opt(pos_i, pos_e, to_pos, instance_);
+    std::span<const uint32_t> nodes { tour.tour_view() };
+    std::vector<uint32_t>& cand { eval_tours_[0] };
+    cand.assign(nodes.begin(), nodes.begin() + pos_i);
+    cand.insert(cand.end(), nodes.begin() + pos_e, nodes.end());
+    cand.insert(cand.begin() + to_pos, nodes.begin() + pos_i, nodes.begin() + pos_e);
+    return evaluate_candidates_(1, { vehicle, 0 }, { std::min(pos_i, to_pos), 0 });
+}
+
+
 void MTSPBC::save_solution(const std::string& points_filepath, const std::string& tour_filepath) {
     std::ofstream fp(points_filepath);
     for (uint32_t i { 0 }; i < instance_.n(); i++) {
@@ -115,8 +720,8 @@ void MTSPBC::save_solution(const std::string& points_filepath, const std::string
     fp.close();
 
     std::ofstream ft(tour_filepath);
-    for (auto t : tours_) {
-        for (auto idx : t.get_tour()) {
+    for (const auto& t : tours_) {
+        for (auto idx : t.tour_view()) {
             ft << instance_.coordinate(idx).pos_x << " " << instance_.coordinate(idx).pos_y << std::endl;
         }
         ft << std::endl << std::endl;
@@ -127,29 +732,200 @@ void MTSPBC::save_solution(const std::string& points_filepath, const std::string
 }
 
 
+/**
+ * @brief Writes the position of every vehicle over time.
+ * @details One line per sampled time, from 0 to the last event in
+ * steps of time_step: the time, then x and y of each vehicle. The
+ * positions are interpolated in blocks by the same kernel as the
+ * max separation.
+ * @param filepath Output file.
+ * @param time_step Time between samples, at least 1.
+ */
+void MTSPBC::save_trajectories(const std::string& filepath, const uint32_t time_step) const {
+    if (time_step == 0) {
+        throw std::logic_error("error: time step must be positive");
+    }
+    sync_();
+    sweep_tours_.resize(k_vehicles_);
+    sweep_events_.resize(k_vehicles_);
+    for (uint32_t k { 0 }; k < k_vehicles_; k++) {
+        sweep_tours_[k] = tours_[k].tour_view();
+        sweep_events_[k] = tours_[k].events_view();
+    }
+    trajectories_.assign(sweep_tours_, sweep_events_, instance_);
+    sweep_cursor_.assign(k_vehicles_, 0);
+    const uint32_t last_time { events_.empty() ? 0 : events_.back().first };
+    std::ofstream fp(filepath);
+    for (uint64_t t { 0 }; t <= last_time; t += time_step * block_events_) {
+        block_times_.clear();
+        for (uint64_t s { t }; s <= last_time && block_times_.size() < block_events_; s += time_step) {
+            block_times_.push_back(static_cast<uint32_t>(s));
+        }
+        interpolate_block_(block_times_);
+        for (size_t q { 0 }; q < block_times_.size(); q++) {
+            fp << block_times_[q];
+            for (uint32_t k { 0 }; k < k_vehicles_; k++) {
+                fp << " " << block_x_[q * k_vehicles_ + k] << " " << block_y_[q * k_vehicles_ + k];
+            }
+            fp << std::endl;
+        }
+    }
+    fp.close();
+}
+
+
 //getters
 [[nodiscard]] uint32_t MTSPBC::get_total_obj() const noexcept { return total_obj_; }
 [[nodiscard]] bool MTSPBC::get_feasibility() const noexcept { return feasible_; }
-[[nodiscard]] uint32_t MTSPBC::get_max_distance() const noexcept { return max_distance_value_; }
-[[nodiscard]] std::vector<std::pair<uint32_t, uint32_t>> MTSPBC::get_events() const noexcept { return events_;}
-[[nodiscard]] std::vector<uint32_t> MTSPBC::get_distances() const noexcept { return max_distance_events_; }
+[[nodiscard]] uint32_t MTSPBC::get_max_distance() const {
+    sync_pairs_();
+    return max_distance_value_;
+}
+/**
+ * @brief Maximum separation of two vehicles over the timeline.
+ * @details Read from the per-pair cache; only the pairs of vehicles
+ * changed since the cache was last read are evaluated again.
+ * @return The separation and the time of the event where it occurs.
+ */
+[[nodiscard]] PairSeparation MTSPBC::pair_separation(const uint32_t vehicle_1, const uint32_t vehicle_2) const {
+    if (vehicle_1 >= k_vehicles_ || vehicle_2 >= k_vehicles_ || vehicle_1 == vehicle_2) {
+        throw std::logic_error("error: invalid vehicle pair");
+    }
+    sync_pairs_();
+    return pair_separation_unchecked_(std::min(vehicle_1, vehicle_2), std::max(vehicle_1, vehicle_2));
+}
+
+
+// maior separação do par k < l entre os eventos de todos os veículos; empate fica com o instante anterior
+[[nodiscard]] PairSeparation MTSPBC::pair_separation_unchecked_(const uint32_t k, const uint32_t l) const noexcept {
+    PairSeparation best { 0, 0 };
+    const size_t base { pair_index_(k, l) * pair_k_ };
+    for (uint32_t m { 0 }; m < pair_k_; m++) {
+        const PairSeparation& entry { pair_max_[base + m] };
+        if (entry.value > best.value || (entry.value == best.value && entry.value > 0 && entry.e_time < best.e_time)) {
+            best = entry;
+        }
+    }
+    return best;
+}
+
+
+/**
+ * @brief Maximum separation between vehicles in continuous time.
+ * @details get_max_distance() samples the separation at the events;
+ * this one takes the exact maximum over every instant, pair by pair
+ * with Trajectories::max_separation, in O(T k) for the whole fleet.
+ * Vehicles with fewer than two nodes are left out, as in the sampled
+ * value, which this one bounds from above before rounding.
+ * @return The separation, its time and the pair; 0 with no such pair.
+ */
+[[nodiscard]] ContinuousSeparation MTSPBC::continuous_max_distance() const {
+    sync_();
+    sweep_tours_.resize(k_vehicles_);
+    sweep_events_.resize(k_vehicles_);
+    for (uint32_t k { 0 }; k < k_vehicles_; k++) {
+        sweep_tours_[k] = tours_[k].tour_view();
+        sweep_events_[k] = tours_[k].events_view();
+    }
+    trajectories_.assign(sweep_tours_, sweep_events_, instance_);
+    ContinuousSeparation best { 0, 0, 0, 0 };
+    for (uint32_t k { 0 }; k + 1 < k_vehicles_; k++) {
+        if (sweep_tours_[k].size() < 2) {
+            continue;
+        }
+        for (uint32_t l { k + 1 }; l < k_vehicles_; l++) {
+            if (sweep_tours_[l].size() < 2) {
+                continue;
+            }
+            ContinuousSeparation pair { trajectories_.max_separation(k, l) };
+            if (pair.value > best.value) {
+                best = pair;
+            }
+        }
+    }
+    return best;
+}
+
+
+[[nodiscard]] std::vector<std::pair<uint32_t, uint32_t>> MTSPBC::get_events() const {
+    sync_();
+    return events_;
+}
+[[nodiscard]] std::vector<uint32_t> MTSPBC::get_distances() const {
+    sync_distances_();
+    return max_distance_events_;
+}
+// soma das separações em todos os eventos, sem percorrer a linha do tempo
+[[nodiscard]] uint64_t MTSPBC::get_distance_sum() const {
+    sync_distances_();
+    return distance_tree_.sum(0, distance_tree_.size());
+}
+
+
+// eventos com tempo em [t_1, t_2], como intervalo [first, last) de índices da linha do tempo
+[[nodiscard]] std::pair<size_t, size_t> MTSPBC::event_range_(const uint32_t t_1, const uint32_t t_2) const {
+    if (t_1 > t_2) {
+        throw std::logic_error("error: invalid time interval");
+    }
+    auto first { std::lower_bound(events_.begin(), events_.end(), std::make_pair(t_1, 0u)) };
+    auto last { std::upper_bound(first, events_.end(), std::make_pair(t_2, UINT32_MAX)) };
+    return { static_cast<size_t>(first - events_.begin()), static_cast<size_t>(last - events_.begin()) };
+}
+
+
+/**
+ * @brief Largest separation at the events in a time window.
+ * @details Read from distance_tree_ in O(log E) once the distances
+ * are in sync; a move that only changed the end of the timeline
+ * sweeps just that part again.
+ * @param t_1, t_2 The window [t_1, t_2].
+ * @return The maximum, 0 if no event falls in the window.
+ */
+[[nodiscard]] uint32_t MTSPBC::max_distance_in(const uint32_t t_1, const uint32_t t_2) const {
+    sync_distances_();
+    auto [first, last] = event_range_(t_1, t_2);
+    return distance_tree_.max(first, last);
+}
+
+
+// soma das separações nos eventos com tempo em [t_1, t_2]
+[[nodiscard]] uint64_t MTSPBC::distance_sum_in(const uint32_t t_1, const uint32_t t_2) const {
+    sync_distances_();
+    auto [first, last] = event_range_(t_1, t_2);
+    return distance_tree_.sum(first, last);
+}
+[[nodiscard]] bool MTSPBC::in_transaction() const noexcept { return in_transaction_; }
+// visões sem cópia da linha do tempo e das distâncias, válidas até a próxima alteração
+[[nodiscard]] std::span<const std::pair<uint32_t, uint32_t>> MTSPBC::timeline_view() const {
+    sync_();
+    return events_;
+}
+[[nodiscard]] std::span<const uint32_t> MTSPBC::distances_view() const {
+    sync_distances_();
+    return max_distance_events_;
+}
 [[nodiscard]] uint32_t MTSPBC::get_n_nodes() const noexcept { return n_nodes_; }
 [[nodiscard]] uint32_t MTSPBC::get_k_vehicles() const noexcept { return k_vehicles_; }
 [[nodiscard]] uint32_t MTSPBC::get_r_radius() const noexcept { return r_radius_; }
 [[nodiscard]] uint32_t MTSPBC::get_cost(const uint32_t node_A, const uint32_t node_B) const { return instance_.cost(node_A, node_B); }
 [[nodiscard]] std::pair<uint32_t, uint32_t> MTSPBC::get_event(const uint32_t e_index) const {
+    sync_();
     if (e_index > events_.size() - 1) {
         throw std::logic_error("error: event out of range");
     }
     return events_.at(e_index);
 }
-[[nodiscard]] uint32_t MTSPBC::get_n_events() const noexcept { return events_.size(); }
+[[nodiscard]] uint32_t MTSPBC::get_n_events() const {
+    sync_();
+    return events_.size();
+}
 [[nodiscard]] Coord MTSPBC::get_coord(uint32_t node) const {
     if (node > instance_.n() - 1) {
         throw std::out_of_range("error: node does not exist");
     }
     return instance_.coordinate(node);
 }
+[[nodiscard]] bool MTSPBC::is_neighbour(const uint32_t node, const uint32_t candidate) const { return instance_.is_neighbour(node, candidate); }
 
 
 // Cht wrapper methods
@@ -158,9 +934,10 @@ uint32_t MTSPBC::insert_node(const uint32_t vehicle, const uint32_t node, const
         throw std::logic_error("error: vehicles do not exist");
     }
     uint32_t old_obj { tours_.at(vehicle).get_obj() };
+    checkpoint_(vehicle, pos);
     uint32_t new_obj { tours_.at(vehicle).insert_node(node, pos, instance_) };
     total_obj_ += new_obj - old_obj;
-    collect_events_();
+    mark_dirty_(vehicle, pos);
     return total_obj_;
 }
 
@@ -170,9 +947,10 @@ uint32_t MTSPBC::remove_node(const uint32_t vehicle, const size_t pos) {
         throw std::logic_error("error: vehicle do not exist");
     }
     uint32_t old_obj { tours_.at(vehicle).get_obj() };
+    checkpoint_(vehicle, pos);
     uint32_t new_obj { tours_.at(vehicle).remove_node(pos, instance_) };
     total_obj_ -= old_obj - new_obj;
-    collect_events_();
+    mark_dirty_(vehicle, pos);
     return total_obj_;
 }
 
@@ -184,12 +962,13 @@ uint32_t MTSPBC::insert_subtour(const uint32_t vehicle, const std::vector<uint32
     if (pos_i > pos_e) {
         throw std::logic_error("error: invalid interval!");
     }
-    if (pos_i > tours_.at(vehicle).get_tour().size() - 1 || pos_e > tours_.at(vehicle).get_tour().size() - 1) {
+    if (pos_i > tours_.at(vehicle).n_nodes() - 1 || pos_e > tours_.at(vehicle).n_nodes() - 1) {
         throw std::logic_error("error: invalid interval");
     }
+    checkpoint_(vehicle, pos_i);
     tours_.at(vehicle).insert_subtour(instance_, subtour_indices, pos_i, pos_e);
     compute_obj_();
-    collect_events_();
+    mark_dirty_(vehicle, pos_i);
     // check_feasibility_();
     return total_obj_;
 }
@@ -202,12 +981,13 @@ uint32_t MTSPBC::replace_subtour(const uint32_t vehicle, const std::vector<uint3
     if (pos_i > pos_e) {
         throw std::logic_error("error: invalid interval!");
     }
-    if (pos_i > tours_.at(vehicle).get_tour().size() - 1 || pos_e > tours_.at(vehicle).get_tour().size() - 1) {
+    if (pos_i > tours_.at(vehicle).n_nodes() - 1 || pos_e > tours_.at(vehicle).n_nodes() - 1) {
         throw std::logic_error("error: invalid interval");
     }
+    checkpoint_(vehicle, pos_i);
     tours_.at(vehicle).replace_subtour(instance_, subtour_indices, pos_i, pos_e);
     compute_obj_();
-    collect_events_();
+    mark_dirty_(vehicle, pos_i);
     return total_obj_;
 }
 
@@ -219,12 +999,13 @@ uint32_t MTSPBC::remove_subtour(const uint32_t vehicle, const uint32_t pos_i, co
     if (pos_i > pos_e) {
         throw std::logic_error("error: invalid interval!");
     }
-    if (pos_i > tours_.at(vehicle).get_tour().size() - 1 || pos_e > tours_.at(vehicle).get_tour().size() - 1) {
+    if (pos_i > tours_.at(vehicle).n_nodes() - 1 || pos_e > tours_.at(vehicle).n_nodes() - 1) {
         throw std::logic_error("error: invalid interval");
     }
+    checkpoint_(vehicle, pos_i);
     tours_.at(vehicle).remove_subtour(instance_, pos_i, pos_e);
     compute_obj_();
-    collect_events_();
+    mark_dirty_(vehicle, pos_i);
     return total_obj_;
 }
 
@@ -236,12 +1017,13 @@ uint32_t MTSPBC::reverse_subtour(const uint32_t vehicle, const uint32_t pos_i, c
     if (pos_i > pos_e) {
         throw std::logic_error("error: invalid interval!");
     }
-    if (pos_i > tours_.at(vehicle).get_tour().size() - 1 || pos_e > tours_.at(vehicle).get_tour().size() - 1) {
+    if (pos_i > tours_.at(vehicle).n_nodes() - 1 || pos_e > tours_.at(vehicle).n_nodes() - 1) {
         throw std::logic_error("error: invalid interval");
     }
+    checkpoint_(vehicle, pos_i);
     tours_.at(vehicle).reverse_subtour(instance_, pos_i, pos_e);
     compute_obj_();
-    collect_events_();
+    mark_dirty_(vehicle, pos_i);
     return total_obj_;
 }
 
@@ -251,9 +1033,11 @@ uint32_t MTSPBC::push_back(const uint32_t vehicle, const uint32_t node) {
         throw std::logic_error("error: vehicle do not exist");
     }
     uint32_t old_obj { tours_.at(vehicle).get_obj() };
+    const size_t pos { tours_.at(vehicle).n_nodes() };
+    checkpoint_(vehicle, pos);
     uint32_t new_obj { tours_.at(vehicle).push_back(node, instance_) };
     total_obj_ += new_obj - old_obj;
-    collect_events_();
+    mark_dirty_(vehicle, pos);
     compute_obj_();
     return total_obj_;
 }
@@ -264,9 +1048,10 @@ uint32_t MTSPBC::push_front(const uint32_t vehicle, const uint32_t node) {
         throw std::logic_error("error: vehicle do not exist");
     }
     uint32_t old_obj { tours_.at(vehicle).get_obj() };
+    checkpoint_(vehicle, 0);
     uint32_t new_obj { tours_.at(vehicle).push_front(node, instance_) };
     total_obj_ += new_obj - old_obj;
-    collect_events_();
+    mark_dirty_(vehicle, 0);
     compute_obj_();
     return total_obj_;
 }
@@ -277,9 +1062,11 @@ uint32_t MTSPBC::pop_back(const uint32_t vehicle) {
         throw std::logic_error("error: vehicle do not exist");
     }
     uint32_t old_obj { tours_.at(vehicle).get_obj() };
+    const size_t pos { (tours_.at(vehicle).n_nodes() == 0) ? 0 : tours_.at(vehicle).n_nodes() - 1 };
+    checkpoint_(vehicle, pos);
     uint32_t new_obj { tours_.at(vehicle).pop_back(instance_) };
     total_obj_ -= old_obj - new_obj;
-    collect_events_();
+    mark_dirty_(vehicle, pos);
     compute_obj_();
     return total_obj_;
 }
@@ -290,9 +1077,10 @@ uint32_t MTSPBC::pop_front(const uint32_t vehicle) {
         throw std::logic_error("error: vehicle do not exist");
     }
     uint32_t old_obj { tours_.at(vehicle).get_obj() };
+    checkpoint_(vehicle, 0);
     uint32_t new_obj { tours_.at(vehicle).pop_front(instance_) };
     total_obj_ -= old_obj - new_obj;
-    collect_events_();
+    mark_dirty_(vehicle, 0);
     compute_obj_();
     return total_obj_;
 }
@@ -302,8 +1090,9 @@ uint32_t MTSPBC::reverse_tour(const uint32_t vehicle) {
     if (k_vehicles_ - 1 < vehicle) {
         throw std::logic_error("error: vehicle does not exist");
     }
+    checkpoint_(vehicle, 0);
     tours_.at(vehicle).reverse_tour(instance_);
-    collect_events_();
+    mark_dirty_(vehicle, 0);
     compute_obj_();
     return 0;
 }
@@ -334,6 +1123,32 @@ uint32_t MTSPBC::reverse_tour(const uint32_t vehicle) {
 }
 
 
+/**
+ * @brief A vehicle that visits a node.
+ * @details The vehicle found last for the node is checked first
+ * with the O(1) position lookup of its tour; only when it no longer
+ * visits the node are the other vehicles checked. The depot is
+ * visited by several vehicles, any of them may be returned.
+ * @param node The node to be found.
+ * @return The vehicle, if some tour visits the node.
+ */
+[[nodiscard]] std::optional<uint32_t> MTSPBC::get_vehicle_for_node(const uint32_t node) const {
+    if (node < node_vehicle_.size() && node_vehicle_[node] < k_vehicles_ && tours_[node_vehicle_[node]].get_pos_for_node(node)) {
+        return node_vehicle_[node];
+    }
+    for (uint32_t k { 0 }; k < k_vehicles_; k++) {
+        if (tours_[k].get_pos_for_node(node)) {
+            if (node >= node_vehicle_.size()) {
+                node_vehicle_.resize(node + 1, no_slot_);
+            }
+            node_vehicle_[node] = k;
+            return k;
+        }
+    }
+    return std::nullopt;
+}
+
+
 [[nodiscard]] uint32_t MTSPBC::get_node_at_pos(const uint32_t vehicle, const size_t pos) const {
     if (k_vehicles_ - 1 < vehicle) {
         throw std::logic_error("error: vehicle does not exist");
@@ -370,6 +1185,23 @@ uint32_t MTSPBC::reverse_tour(const uint32_t vehicle) {
 }
 
 
+// visões sem cópia, válidas até a próxima alteração do veículo
+[[nodiscard]] std::span<const uint32_t> MTSPBC::tour_view(const uint32_t vehicle) const {
+    if (k_vehicles_ - 1 < vehicle) {
+        throw std::logic_error("error: vehicle do not exist");
+    }
+    return tours_[vehicle].tour_view();
+}
+
+
+[[nodiscard]] std::span<const uint32_t> MTSPBC::events_view(const uint32_t vehicle) const {
+    if (k_vehicles_ - 1 < vehicle) {
+        throw std::logic_error("error: vehicle do not exist");
+    }
+    return tours_[vehicle].events_view();
+}
+
+
 [[nodiscard]] uint32_t MTSPBC::n_nodes(const uint32_t vehicle) const {
     if (k_vehicles_ - 1 < vehicle) {
         throw std::logic_error("error: vehicle do not exist");
@@ -402,6 +1234,7 @@ uint32_t MTSPBC::reverse_tour(const uint32_t vehicle) {
 
 
 [[nodiscard]] uint32_t MTSPBC::dist_at_event(const uint32_t e_index) const {
+    sync_distances_();
     if (e_index > events_.size() - 1) {
         throw std::logic_error("error: event index out of range");
     }
@@ -415,3 +1248,11 @@ uint32_t MTSPBC::reverse_tour(const uint32_t vehicle) {
     }
     return tours_.at(vehicle).event_index(e_time);
 }
+
+
+[[nodiscard]] size_t MTSPBC::last_event_at(const uint32_t vehicle, const uint32_t e_time) const {
+    if (k_vehicles_ - 1 < vehicle) {
+        throw std::logic_error("error: vehicle do not exist");
+    }
+    return tours_[vehicle].last_event_at(e_time);
+}
@@ -1,22 +1,27 @@
 #include "MTSPBCInstance.hpp"
+#include "CoverBuilder.hpp"
+#include "DistanceBuilder.hpp"
+#include "InstanceCache.hpp"
+#include "TextParser.hpp"
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <stdexcept>
 #include <fstream>
+#include <optional>
 #include <sstream>
+#include <span>
 #include <string>
+#include <utility>
 #include <vector>
 
 
-InstanceData MTSPBCInstance::parse_instance(const std::string& inst_filepath, const std::string& dist_filepath, const std::string& cover_filepath) {
-    InstanceData data;
+void MTSPBCInstance::parse_coordinates_(const std::string& inst_filepath, InstanceData& data) {
     std::ifstream input_instance(inst_filepath);
-    std::ifstream input_dist(dist_filepath);
-    std::ifstream input_cover(cover_filepath);
     bool parameters_read {false};
 
     // checks if it was open
-    if(!input_instance.is_open() || !input_dist.is_open()) {
+    if(!input_instance.is_open()) {
         throw std::runtime_error("error: could not open file");
     }
 
@@ -31,17 +36,7 @@ InstanceData MTSPBCInstance::parse_instance(const std::string& inst_filepath, co
         if (!parameters_read) {
             ss >> data.k_vehicles >> data.n_nodes >> data.r_radius;
             data.n_nodes++;                  // adiciona garagem ao número de nós
-            data.cost_matrix.resize(data.n_nodes, std::vector<uint32_t>(data.n_nodes));     // aloca matriz de distancias
-            data.UB.resize(data.n_nodes);
-            data.LB.resize(data.n_nodes);
-            for (size_t i {}; i < data.n_nodes; i++) {
-                data.UB.at(i).resize(data.n_nodes);
-                data.LB.at(i).resize(data.n_nodes);
-                for (size_t j {}; j < data.n_nodes; j++) {
-                    data.UB.at(i).at(j).resize(data.n_nodes);
-                    data.LB.at(i).at(j).resize(data.n_nodes);
-                }
-            }
+            data.cost_matrix = CostMatrix(data.n_nodes);      // aloca matriz de distancias
             parameters_read = true;
         } else {
             Coord new_coord;
@@ -50,64 +45,142 @@ InstanceData MTSPBCInstance::parse_instance(const std::string& inst_filepath, co
         }
     }
     input_instance.close();
-    parameters_read = false;
-    while (std::getline(input_dist, line)) {
-        if (line.empty() || line[0] == '#') {
-            continue;
-        }
-        std::stringstream ss(line);
-        if (!parameters_read) {
-            parameters_read = true;
-        }
-        else {
-            uint32_t node_A {};
-            uint32_t node_B {};
-            uint32_t dist_AB {};
-            ss >> node_A >> node_B >> dist_AB;
-            data.cost_matrix.at(node_A).at(node_B) = dist_AB;
-        }
-    }
-    input_dist.close();
-    if (!input_cover.is_open()) {
-        throw std::runtime_error("error: cover file not found");
+}
+
+
+InstanceData MTSPBCInstance::parse_instance(const std::string& inst_filepath, const std::string& dist_filepath, const std::string& cover_filepath) {
+    InstanceData data;
+    parse_coordinates_(inst_filepath, data);
+    parse_dist_file(dist_filepath, data.cost_matrix);
+    std::vector<CoverTriple> triples { parse_cover_file(cover_filepath, data.n_nodes) };
+    data.cover = CoverIndex(data.n_nodes, std::move(triples));
+    return data;
+}
+
+
+// calcula a cobertura a partir das coordenadas e do raio, sem cover.dat
+InstanceData MTSPBCInstance::parse_instance(const std::string& inst_filepath, const std::string& dist_filepath) {
+    InstanceData data;
+    parse_coordinates_(inst_filepath, data);
+    parse_dist_file(dist_filepath, data.cost_matrix);
+    data.cover = build_cover(data.coordinates, data.cost_matrix, data.r_radius);
+    return data;
+}
+
+
+// calcula distâncias e cobertura a partir das coordenadas, sem inst.dat nem cover.dat
+InstanceData MTSPBCInstance::parse_instance(const std::string& inst_filepath) {
+    InstanceData data;
+    parse_coordinates_(inst_filepath, data);
+    if (data.coordinates.size() != data.n_nodes) {
+        throw std::runtime_error("error: number of coordinates does not match the instance header");
     }
-    while (std::getline(input_cover, line)) {
-        std::stringstream ss(line);
-        uint32_t covered_node {};
-        uint32_t departure_node {};
-        uint32_t arrival_node {};
-        double read_LB {};
-        double read_UB {};
-        ss >> covered_node >> departure_node >> arrival_node >> read_LB >> read_UB;
-        data.LB.at(covered_node).at(departure_node).at(arrival_node) = read_LB;
-        data.UB.at(covered_node).at(departure_node).at(arrival_node) = read_UB;
+    data.cost_matrix = build_cost_matrix(data.coordinates);
+    data.cover = build_cover(data.coordinates, data.cost_matrix, data.r_radius);
+    return data;
+}
+
+
+InstanceData MTSPBCInstance::make_data_(std::vector<Coord>&& coordinates, const uint32_t k_vehicles, const uint32_t r_radius,
+                                        std::optional<CostMatrix>&& cost_matrix, std::optional<CoverIndex>&& cover) {
+    InstanceData data;
+    data.k_vehicles = k_vehicles;
+    data.n_nodes = coordinates.size();
+    data.r_radius = r_radius;
+    data.coordinates = std::move(coordinates);
+    data.cost_matrix = cost_matrix ? std::move(*cost_matrix) : build_cost_matrix(data.coordinates);
+    data.cover = cover ? std::move(*cover) : build_cover(data.coordinates, data.cost_matrix, data.r_radius);
+    return data;
+}
+
+
+// usa o cache binário se ele foi compilado a partir dos mesmos arquivos texto, senão lê e regrava o cache
+InstanceData MTSPBCInstance::load_cached_(const std::string& inst_filepath, const std::string& dist_filepath, const std::string& cover_filepath, const std::string& cache_filepath) {
+    uint64_t checksum { source_checksum({ inst_filepath, dist_filepath, cover_filepath }) };
+    auto cached { read_cache_checksum(cache_filepath) };
+    if (cached && cached.value() == checksum) {
+        return open_instance_cache(cache_filepath);
     }
-    input_cover.close();
+    InstanceData data { parse_instance(inst_filepath, dist_filepath, cover_filepath) };
+    data.cost_matrix = CostMatrix::compress(std::move(data.cost_matrix));
+    write_instance_cache(cache_filepath, data, checksum);
     return data;
 }
 
 
-MTSPBCInstance::MTSPBCInstance(const InstanceData& data)
-: cost_matrix_(data.cost_matrix),
-coordinates_(data.coordinates),
+MTSPBCInstance::MTSPBCInstance(const std::string& instance_filepath, const std::string& dist_filepath, const std::string& cover_filepath)
+: MTSPBCInstance(parse_instance(instance_filepath, dist_filepath, cover_filepath)) {}
+
+
+MTSPBCInstance::MTSPBCInstance(const std::string& instance_filepath, const std::string& dist_filepath)
+: MTSPBCInstance(parse_instance(instance_filepath, dist_filepath)) {}
+
+
+MTSPBCInstance::MTSPBCInstance(const std::string& instance_filepath, const std::string& dist_filepath, const std::string& cover_filepath, const std::string& cache_filepath)
+: MTSPBCInstance(load_cached_(instance_filepath, dist_filepath, cover_filepath, cache_filepath)) {}
+
+
+MTSPBCInstance::MTSPBCInstance(const std::string& filepath)
+: MTSPBCInstance(read_cache_checksum(filepath) ? open_instance_cache(filepath) : parse_instance(filepath)) {}
+
+
+/**
+ * @brief Builds an instance from data already in memory.
+ * @details Every member is moved in, nothing is copied. The
+ * matrices must be sized for data.n_nodes, depot included.
+ */
+MTSPBCInstance::MTSPBCInstance(InstanceData&& data)
+: cost_matrix_(CostMatrix::compress(std::move(data.cost_matrix))),
+cover_(std::move(data.cover)),
+coordinates_(std::move(data.coordinates)),
 k_vehicles_(data.k_vehicles),
-r_radius_(data.r_radius),
 n_nodes_(data.n_nodes),
-LB_(data.LB),
-UB_(data.UB) {}
+r_radius_(data.r_radius),
+n_neighbours_(std::min(default_neighbours, std::max<uint32_t>(n_nodes_, 1) - 1)),
+neighbours_(build_neighbour_lists(cost_matrix_, n_neighbours_)),
+grid_(coordinates_, std::max(static_cast<double>(r_radius_), 1.0)) {
+    if (cost_matrix_.n() != n_nodes_ || cover_.n() != n_nodes_) {
+        throw std::logic_error("error: instance matrices do not match the number of nodes");
+    }
+    if (!coordinates_.empty() && coordinates_.size() != n_nodes_) {
+        throw std::logic_error("error: number of coordinates does not match the number of nodes");
+    }
+}
 
 
-MTSPBCInstance::MTSPBCInstance(const std::string& instance_filepath, const std::string& dist_filepath, const std::string& cover_filepath)
-: MTSPBCInstance(parse_instance(instance_filepath, dist_filepath, cover_filepath)) {}
+/**
+ * @brief Builds an instance from coordinates, without files.
+ * @details Node 0 is the depot. Matrices that are not given are
+ * computed in-process from the coordinates and the radius; the
+ * given ones are moved in.
+ * @param coordinates The node coordinates, depot first.
+ * @param k_vehicles The number of vehicles.
+ * @param r_radius The cover radius.
+ * @param cost_matrix Optional pre-computed cost matrix.
+ * @param cover Optional pre-computed cover index.
+ */
+MTSPBCInstance::MTSPBCInstance(std::vector<Coord>&& coordinates, const uint32_t k_vehicles, const uint32_t r_radius,
+                               std::optional<CostMatrix>&& cost_matrix, std::optional<CoverIndex>&& cover)
+: MTSPBCInstance(make_data_(std::move(coordinates), k_vehicles, r_radius, std::move(cost_matrix), std::move(cover))) {}
 
 
 [[nodiscard]] double MTSPBCInstance::get_LB(const uint32_t covered_node, const uint32_t departure_node, const uint32_t arrival_node) const {
-    return LB_[covered_node][departure_node][arrival_node];
+    return cover_.get_LB(covered_node, departure_node, arrival_node);
 }
 
 
 [[nodiscard]] double MTSPBCInstance::get_UB(const uint32_t covered_node, const uint32_t departure_node, const uint32_t arrival_node) const {
-    return UB_[covered_node][departure_node][arrival_node];
+    return cover_.get_UB(covered_node, departure_node, arrival_node);
+}
+
+
+[[nodiscard]] bool MTSPBCInstance::covers(const uint32_t covered_node, const uint32_t departure_node, const uint32_t arrival_node) const {
+    return cover_.covers(covered_node, departure_node, arrival_node);
+}
+
+
+[[nodiscard]] std::span<const CoverWindow> MTSPBCInstance::covered_by(const uint32_t departure_node, const uint32_t arrival_node) const {
+    return cover_.covered_by(departure_node, arrival_node);
 }
 
 
@@ -115,7 +188,46 @@ MTSPBCInstance::MTSPBCInstance(const std::string& instance_filepath, const std::
     if ((node_A > n_nodes_ - 1) || (node_B > n_nodes_ - 1)) {
         throw std::logic_error("error: node does not exist");
     }
-    return cost_matrix_.at(node_A).at(node_B);
+    return cost_matrix_.get(node_A, node_B);
+}
+
+
+// nós candidatos para vizinhanças granulares, do mais próximo ao mais distante
+[[nodiscard]] std::span<const uint32_t> MTSPBCInstance::neighbours(const uint32_t node) const {
+    if (node > n_nodes_ - 1) {
+        throw std::out_of_range("error: node does not exist");
+    }
+    return std::span<const uint32_t>(neighbours_).subspan(static_cast<size_t>(node) * n_neighbours_, n_neighbours_);
+}
+
+
+[[nodiscard]] bool MTSPBCInstance::is_neighbour(const uint32_t node, const uint32_t candidate) const {
+    auto list { neighbours(node) };
+    return std::find(list.begin(), list.end(), candidate) != list.end();
+}
+
+
+[[nodiscard]] uint32_t MTSPBCInstance::n_neighbours() const noexcept { return n_neighbours_; }
+
+
+[[nodiscard]] const SpatialGrid& MTSPBCInstance::spatial_index() const noexcept { return grid_; }
+
+
+// nós a até r_radius de um ponto, ordenados por nó
+void MTSPBCInstance::nodes_within(const Coord& point, std::vector<uint32_t>& out) const {
+    grid_.within_radius(point, r_radius_, out);
+}
+
+
+// nós que a aresta pode cobrir: a até r_radius do segmento, ordenados por nó
+void MTSPBCInstance::nodes_near_edge(const uint32_t departure_node, const uint32_t arrival_node, std::vector<uint32_t>& out) const {
+    grid_.near_segment(coordinate(departure_node), coordinate(arrival_node), r_radius_, out);
+}
+
+
+// k nós mais próximos de um ponto, do mais próximo ao mais distante
+void MTSPBCInstance::nearest_nodes(const Coord& point, const uint32_t k, std::vector<uint32_t>& out) const {
+    grid_.nearest(point, k, out);
 }
 
 
@@ -4,7 +4,6 @@
 #include "MTSPBC_ds.hpp"
 #include <cstddef>
 #include <cstdint>
-#include <numeric>
 #include <sys/types.h>
 #include <iostream>
 #include <utility>
@@ -26,18 +25,20 @@ uint32_t opt_4(MTSPBC& solution, const uint32_t k1, const uint32_t k2, Edge k1_1
 
 
 bool opt_3_min_dist_event(MTSPBC& solution, const MTSPBCInstance& instance, const uint32_t k_1, const uint32_t k_2, const Edge k_1_edge, const uint32_t k_2_n_i) {
-    int old_e_dist { std::accumulate(solution.get_distances().begin(), solution.get_distances().end(), 0) };
+    uint64_t old_e_dist { solution.get_distance_sum() };
     uint32_t k2_remove_node { solution.get_node_at_pos(k_2, k_2_n_i) };
     uint32_t k1_insert_pos { k_1_edge.node_B.first };
+    // desfazer pelo journal restaura as rotas e a linha do tempo sem recalcular
+    solution.begin();
     solution.insert_node(k_1, k2_remove_node, k1_insert_pos);
     solution.remove_node(k_2, k_2_n_i);
-    int new_e_dist { std::accumulate(solution.get_distances().begin(), solution.get_distances().end(), 0) };
+    uint64_t new_e_dist { solution.get_distance_sum() };
     if (new_e_dist < old_e_dist) {
+        solution.commit();
         return true;
     }
     else {
-        solution.insert_node(k_2, k2_remove_node, k_2_n_i);
-        solution.remove_node(k_1, k1_insert_pos);
+        solution.rollback();
         return false;
     }
 }
@@ -72,7 +73,7 @@ void minimize_e_dist(MTSPBC& solution, const MTSPBCInstance& instance) {
 }
 
 
-void minimize_e_dist_2(MTSPBC& solution, const MTSPBCInstance& instance) {
+void minimize_e_dist_2(MTSPBC& solution, const MTSPBCInstance& instance, const bool granular) {
     bool has_improved { true };
     int32_t stop_improv { 1000 };
     begin_loop :
@@ -85,6 +86,13 @@ void minimize_e_dist_2(MTSPBC& solution, const MTSPBCInstance& instance) {
                 for (uint32_t m { 1 }; m < solution.n_nodes(i) - 1; m++) {
                     for (uint32_t n { 0 }; n < solution.n_nodes(j) - 1; n++) {
                         Edge i_e1 { solution.edge(i, n) };
+                        // vizinhança granular: só move o nó para perto de um vizinho próximo
+                        if (granular) {
+                            uint32_t moved_node { solution.get_node_at_pos(j, m) };
+                            if (!instance.is_neighbour(moved_node, i_e1.A_node()) && !instance.is_neighbour(moved_node, i_e1.B_node())) {
+                                continue;
+                            }
+                        }
                         bool improvement { opt_3_min_dist_event(solution, instance, i, j, i_e1, m) };
                         if (improvement) {
                             has_improved = true;
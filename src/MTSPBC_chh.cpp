@@ -6,8 +6,10 @@
 #include <cstddef>
 #include <cstdint>
 #include <optional>
+#include <span>
 #include <stdexcept>
 #include <sys/types.h>
+#include <utility>
 #include <vector>
 #include <algorithm>
 
@@ -78,57 +80,207 @@ uint32_t find_onion_hull(MTSPBC& solution, std::vector<size_t>& un_nodes, const
     // iterativamente, encontra uma rota para cada veículo
     for (uint32_t i{ 0 }; i < k_vehicles; i++) {
         add_convex_hull(solution, i, un_nodes, instance);
-        unassign(solution.get_tour(i), un_nodes);
+        unassign(solution.tour_view(i), un_nodes);
     }
     return 0;
 }
 
 
-uint32_t cheapest_insertion(MTSPBC& solution, std::vector<size_t>& un_nodes, const MTSPBCInstance& instance, const bool closed_tour) {      // find heuristic solution
+// ocorrência de um nó numa rota, com os vizinhos dela; no_node nas pontas
+struct TourSlot {
+    uint32_t vehicle;
+    uint32_t prev;
+    uint32_t next;
+};
+constexpr uint32_t no_node { UINT32_MAX };
+
+
+// ocorrências de cada nó nas rotas, em ordem de veículo
+static std::vector<std::vector<TourSlot>> collect_tour_slots(const MTSPBC& solution, const uint32_t n_nodes) {
+    std::vector<std::vector<TourSlot>> slots(n_nodes);
+    for (uint32_t k { 0 }; k < solution.get_k_vehicles(); k++) {
+        std::span<const uint32_t> tour { solution.tour_view(k) };
+        for (size_t i { 0 }; i < tour.size(); i++) {
+            slots[tour[i]].push_back({ k, (i > 0) ? tour[i - 1] : no_node, (i + 1 < tour.size()) ? tour[i + 1] : no_node });
+        }
+    }
+    return slots;
+}
+
+
+// ocorrência de node na rota vehicle com o vizinho dado (anterior se before, senão seguinte)
+static TourSlot* find_slot(std::vector<std::vector<TourSlot>>& slots, const uint32_t node, const uint32_t vehicle,
+                           const uint32_t neighbour, const bool before) {
+    for (TourSlot& slot : slots[node]) {
+        if (slot.vehicle == vehicle && (before ? slot.prev : slot.next) == neighbour) {
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+
+/**
+ * @brief Updates the slots after an insertion.
+ * @details Inserting node at pos only changes its two neighbours:
+ * the one before now leads to node and the one after comes from it.
+ * node gets a slot of its own; no other slot moves.
+ */
+static void insert_tour_slot(std::vector<std::vector<TourSlot>>& slots, const MTSPBC& solution, const uint32_t vehicle, const size_t pos) {
+    std::span<const uint32_t> tour { solution.tour_view(vehicle) };
+    const uint32_t node { tour[pos] };
+    const uint32_t prev { (pos > 0) ? tour[pos - 1] : no_node };
+    const uint32_t next { (pos + 1 < tour.size()) ? tour[pos + 1] : no_node };
+    if (prev != no_node) {
+        if (TourSlot* slot { find_slot(slots, prev, vehicle, next, false) }) {
+            slot->next = node;
+        }
+    }
+    if (next != no_node) {
+        if (TourSlot* slot { find_slot(slots, next, vehicle, prev, true) }) {
+            slot->prev = node;
+        }
+    }
+    std::vector<TourSlot>& own { slots[node] };
+    auto it { std::find_if(own.begin(), own.end(), [&](const TourSlot& slot) { return slot.vehicle > vehicle; }) };
+    own.insert(it, { vehicle, prev, next });
+}
+
+
+/**
+ * @brief Granular step of the cheapest insertion.
+ * @details Only tries to insert an unassigned node right before or
+ * right after one of its nearest nodes, so each node costs O(k)
+ * insertion positions instead of every position of every tour.
+ * The neighbours come from the slots kept across steps, and only
+ * the position of the best insertion is looked up in its tour.
+ * Costs are the same as in the full scan.
+ * @return True if some insertion was found.
+ */
+static bool granular_insertion(const MTSPBC& solution, std::vector<std::vector<TourSlot>>& slots, const std::vector<size_t>& un_nodes,
+                               const MTSPBCInstance& instance, const bool closed_tour,
+                               uint32_t& k_index, uint32_t& position, uint32_t& new_cost, uint32_t& unassigned_index) {
+    bool found { false };
+    uint32_t best_node { };
+    uint32_t best_prev { };
+    bool best_after { };
+    for (uint32_t un { 0 }; un < un_nodes.size(); un++) {
+        const uint32_t inserted_node = un_nodes[un];
+        for (uint32_t candidate : instance.neighbours(inserted_node)) {
+            for (const TourSlot& slot : slots[candidate]) {
+                const uint32_t k { slot.vehicle };
+                const uint32_t base { solution.get_obj_vehicle(k) };
+                // antes do vizinho: numa rota fechada, não antes do primeiro nem no lugar do último
+                if (!closed_tour || (slot.prev != no_node && slot.next != no_node)) {
+                    uint32_t temp_cost { base + instance.cost_unchecked(candidate, inserted_node) };
+                    if (slot.prev != no_node) {
+                        temp_cost += instance.cost_unchecked(slot.prev, inserted_node);
+                    }
+                    if (temp_cost < new_cost) {
+                        k_index = k;
+                        new_cost = temp_cost;
+                        unassigned_index = un;
+                        best_node = candidate;
+                        best_prev = slot.prev;
+                        best_after = false;
+                        found = true;
+                    }
+                }
+                // depois do vizinho: precisa de um seguinte, e numa rota fechada ele não pode ser o último
+                if (slot.next == no_node) {
+                    continue;
+                }
+                if (closed_tour) {
+                    const TourSlot* next { find_slot(slots, slot.next, k, candidate, true) };
+                    if (next == nullptr || next->next == no_node) {
+                        continue;
+                    }
+                }
+                uint32_t temp_cost { base + instance.cost_unchecked(candidate, inserted_node) + instance.cost_unchecked(slot.next, inserted_node) };
+                if (temp_cost < new_cost) {
+                    k_index = k;
+                    new_cost = temp_cost;
+                    unassigned_index = un;
+                    best_node = candidate;
+                    best_prev = slot.prev;
+                    best_after = true;
+                    found = true;
+                }
+            }
+        }
+    }
+    if (found) {
+        std::span<const uint32_t> tour { solution.tour_view(k_index) };
+        for (uint32_t q { 0 }; q < tour.size(); q++) {
+            if (tour[q] == best_node && ((q > 0) ? tour[q - 1] : no_node) == best_prev) {
+                position = best_after ? q + 1 : q;
+                break;
+            }
+        }
+    }
+    return found;
+}
+
+
+uint32_t cheapest_insertion(MTSPBC& solution, std::vector<size_t>& un_nodes, const MTSPBCInstance& instance, const bool closed_tour, const bool granular) {      // find heuristic solution
     if (solution.get_total_obj() == 0) {
         throw std::logic_error("error: cheapest heuristic over empty solution not allowed");
     }
+    // índice de vizinhos montado uma vez e atualizado a cada inserção
+    std::vector<std::vector<TourSlot>> slots {};
+    if (granular) {
+        slots = collect_tour_slots(solution, instance.n());
+    }
     while(un_nodes.size() > 0) {
         uint32_t k_index {};
         uint32_t position {};
         uint32_t new_cost { 999999 };
         uint32_t unassigned_index {};
-        for (auto un { 0 }; un < un_nodes.size(); un++) {
-            // uint32_t curr_best_obj { 999999 };
-            // uint32_t curr_best_k { 0 };
-            for (auto k{ 0 }; k < solution.get_k_vehicles(); k++) {
-                // if (solution.get_obj_vehicle(k) < curr_best_obj) {
-                //     curr_best_obj = solution.get_obj_vehicle(k);
-                //     curr_best_k = k;
-                // }
-                uint32_t closed_i = (closed_tour) ? 1 : 0;
-                for (auto i{ closed_i }; i < solution.get_tour(k).size() - closed_i; i++) {
-                    std::vector<uint32_t> insertion_hull { solution.get_tour(k) };
-                    size_t past_node {};
-                    if (i > 0) {
-                        past_node = insertion_hull.at(i - 1);
-                    }
-                    size_t inserted_node { un_nodes[un] };
-                    size_t next_node { insertion_hull.at(i) };
-                    insertion_hull.insert(insertion_hull.begin() + i, un_nodes[un]);
-                    uint32_t temp_cost { solution.get_obj_vehicle(k) };
-                    if (i == 0) {
-                        temp_cost += solution.get_cost(next_node, inserted_node);
-                    }
-                    else {
-                        temp_cost += solution.get_cost(past_node, inserted_node) + solution.get_cost(next_node, inserted_node);
-                    }
-                    if (temp_cost < new_cost) { // && curr_best_k == k) {
-                        position = i;
-                        k_index = k;
-                        new_cost = temp_cost;
-                        unassigned_index = un;
+        bool found { false };
+        if (granular) {
+            found = granular_insertion(solution, slots, un_nodes, instance, closed_tour, k_index, position, new_cost, unassigned_index);
+        }
+        // sem vizinho já em rota, volta para a busca completa
+        if (!found) {
+            for (auto un { 0 }; un < un_nodes.size(); un++) {
+                // uint32_t curr_best_obj { 999999 };
+                // uint32_t curr_best_k { 0 };
+                for (auto k{ 0 }; k < solution.get_k_vehicles(); k++) {
+                    // if (solution.get_obj_vehicle(k) < curr_best_obj) {
+                    //     curr_best_obj = solution.get_obj_vehicle(k);
+                    //     curr_best_k = k;
+                    // }
+                    uint32_t closed_i = (closed_tour) ? 1 : 0;
+                    std::span<const uint32_t> tour { solution.tour_view(k) };
+                    for (auto i{ closed_i }; i < tour.size() - closed_i; i++) {
+                        size_t past_node {};
+                        if (i > 0) {
+                            past_node = tour[i - 1];
+                        }
+                        size_t inserted_node { un_nodes[un] };
+                        size_t next_node { tour[i] };
+                        uint32_t temp_cost { solution.get_obj_vehicle(k) };
+                        if (i == 0) {
+                            temp_cost += instance.cost_unchecked(next_node, inserted_node);
+                        }
+                        else {
+                            temp_cost += instance.cost_unchecked(past_node, inserted_node) + instance.cost_unchecked(next_node, inserted_node);
+                        }
+                        if (temp_cost < new_cost) { // && curr_best_k == k) {
+                            position = i;
+                            k_index = k;
+                            new_cost = temp_cost;
+                            unassigned_index = un;
+                        }
                     }
                 }
             }
         }
         solution.insert_node(k_index, un_nodes[unassigned_index], position);
-        unassign(solution.get_tour(k_index), un_nodes);
+        if (granular) {
+            insert_tour_slot(slots, solution, k_index, position);
+        }
+        unassign(solution.tour_view(k_index), un_nodes);
     }
     for (uint32_t i { 0 }; i < solution.get_k_vehicles(); i++) {
         solution.reverse_tour(i);
@@ -137,7 +289,41 @@ uint32_t cheapest_insertion(MTSPBC& solution, std::vector<size_t>& un_nodes, con
 }
 
 
-uint32_t assign_garage(MTSPBC &solution, std::vector<size_t>& un_nodes) {
+/**
+ * @brief Granular depot insertion for one tour.
+ * @details Only the positions right before or right after a
+ * nearest node of the depot are tried, at the cost of the two
+ * edges that reach the depot.
+ * @return True if the tour holds some nearest node of the depot.
+ */
+static bool granular_depot_position(const MTSPBC& solution, const uint32_t vehicle, uint32_t& position) {
+    std::span<const uint32_t> tour { solution.tour_view(vehicle) };
+    uint32_t new_cost { UINT32_MAX };
+    bool found { false };
+    for (uint32_t p { 0 }; p < tour.size(); p++) {
+        if (!solution.is_neighbour(0, tour[p])) {
+            continue;
+        }
+        for (uint32_t i : { p, p + 1 }) {
+            if (i >= tour.size()) {
+                continue;
+            }
+            uint32_t temp_cost { solution.get_cost(0, tour[i]) };
+            if (i > 0) {
+                temp_cost += solution.get_cost(tour[i - 1], 0);
+            }
+            if (temp_cost < new_cost) {
+                position = i;
+                new_cost = temp_cost;
+                found = true;
+            }
+        }
+    }
+    return found;
+}
+
+
+uint32_t assign_garage(MTSPBC &solution, std::vector<size_t>& un_nodes, const bool granular) {
 
     std::optional<uint32_t> vehicle_at_depot { std::nullopt };
 
@@ -159,15 +345,18 @@ uint32_t assign_garage(MTSPBC &solution, std::vector<size_t>& un_nodes) {
         }
         uint32_t new_cost{ 999999 };
         uint32_t position{};
-        for (uint32_t i{ 0 }; i < solution.get_tour(k).size(); i++) {
-            std::vector<uint32_t> insertion_hull { solution.get_tour(k) };
-            insertion_hull.insert(insertion_hull.begin() + i, 0);
+        if (granular && granular_depot_position(solution, k, position)) {
+            solution.insert_node(k, 0, position);
+            continue;
+        }
+        std::span<const uint32_t> tour { solution.tour_view(k) };
+        for (uint32_t i{ 0 }; i < tour.size(); i++) {
             size_t past_node {};
             if (i > 0) {
-                past_node = insertion_hull.at(i - 1);
+                past_node = tour[i - 1];
             }
-            size_t next_node { insertion_hull.at(i) };
-            insertion_hull.insert(insertion_hull.begin() + i, 0);
+            // o nó seguinte é o depósito já inserido em i, como na cópia com a inserção
+            size_t next_node { 0 };
             uint32_t temp_cost { solution.get_obj_vehicle(k) };
             if (i == 0) {
                 temp_cost += solution.get_cost(next_node, 0);
@@ -271,36 +460,38 @@ uint32_t remove_covered_nodes(MTSPBC& solution, const MTSPBCInstance& instance,
 }
 
 
-uint32_t maxd_best_3opt(MTSPBC& solution, const MTSPBCInstance& instance) {
+uint32_t maxd_best_3opt(MTSPBC& solution, const MTSPBCInstance& instance, const bool granular) {
     uint32_t best_k_rem { };
     uint32_t best_n_rem { };
     uint32_t best_k_ins { };
     uint32_t best_pos_ins { };
     uint32_t max_distance { solution.get_max_distance() };
     bool has_improved { false };
-    while (has_improved) {
+    do {
         has_improved = false;
         for (uint32_t i { }; i < solution.get_k_vehicles(); i++) {
-            for (uint32_t j { 1 }; j < solution.get_tour(i).size() - 1; j++) {
+            for (uint32_t j { 1 }; j + 1 < solution.n_nodes(i); j++) {
                 for (uint32_t k { }; k < solution.get_k_vehicles(); k++) {
                     if (i == k) continue;
-                    for (uint32_t l { 1 }; l < solution.get_tour(k).size() - 1; l++) {
+                    for (uint32_t l { 1 }; l + 1 < solution.n_nodes(k) && j + 1 < solution.n_nodes(i); l++) {
                         uint32_t removed_node { solution.get_node_at_pos(i, j) };
-                        solution.remove_node(i, j);
-                        solution.insert_node(k, removed_node, l);
-                        uint32_t tmp_max_distance { solution.get_max_distance() };
-                        if (tmp_max_distance < max_distance) {
-                            max_distance = tmp_max_distance;
+                        // vizinhança granular: só reinsere ao lado de um vizinho próximo
+                        if (granular && !instance.is_neighbour(removed_node, solution.get_node_at_pos(k, l - 1))
+                            && !instance.is_neighbour(removed_node, solution.get_node_at_pos(k, l))) {
+                            continue;
+                        }
+                        // avalia sem alterar a solução; só aplica se melhora
+                        MoveDelta delta { solution.evaluate_relocate(i, j, k, l) };
+                        if (static_cast<int64_t>(solution.get_max_distance()) + delta.max_distance < max_distance) {
+                            solution.remove_node(i, j);
+                            solution.insert_node(k, removed_node, l);
+                            max_distance = solution.get_max_distance();
                             has_improved = true;
-                        } else {
-                            has_improved |= false;
-                            solution.remove_node(k, l);
-                            solution.insert_node(i, removed_node, j);
                         }
                     }
                 }
             }
         }
-    }
+    } while (has_improved);
     return max_distance;
 }
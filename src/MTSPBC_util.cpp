@@ -1,9 +1,11 @@
 #include "MTSPBC_util.hpp"
 #include "MTSPBC_ds.hpp"
 #include "MTSPBC.hpp"
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <cmath>
+#include <span>
 #include <utility>
 #include <vector>
 
@@ -46,108 +48,108 @@ uint32_t distance(const Coord& a, const Coord& b) {
 }
 
 
+/**
+ * @brief Position of a vehicle at a given time.
+ * @details Finds the edge the vehicle is on with a binary search
+ * over its events, on borrowed views of the tour and the events,
+ * and interpolates along it. After its last event the vehicle
+ * stays at its last node.
+ */
+Coord position_at(const MTSPBC& solution, const uint32_t vehicle, const uint32_t e_time) {
+    std::span<const uint32_t> tour { solution.tour_view(vehicle) };
+    std::span<const uint32_t> events { solution.events_view(vehicle) };
+    size_t last_e_i { solution.last_event_at(vehicle, e_time) };
+    if (last_e_i == tour.size() - 1) {
+        return solution.get_coord(tour.back());
+    }
+    return partial_coordinate(solution.get_coord(tour[last_e_i]), solution.get_coord(tour[last_e_i + 1]), e_time - events[last_e_i]);
+}
+
+
 uint32_t distance(const MTSPBC& solution, const uint32_t event_index, const uint32_t moving_vehicle) {
-    auto event { solution.get_event(event_index) };
-    auto e_time { event.first };
-    auto e_vehicle { event.second };
+    auto [e_time, e_vehicle] = solution.get_event(event_index);
     auto e_node { solution.get_node_at_event(e_vehicle, e_time) };
-    auto mv_events { solution.get_vehicle_events(moving_vehicle) };
-    uint32_t last_e_mv { };
-    uint32_t last_e_mv_i { };
-    for (uint32_t t { 0 }; t < mv_events.size(); t++) {
-        if (mv_events.at(t) > e_time) {
-            break;
-        }
-        last_e_mv = mv_events.at(t);
-        last_e_mv_i = t;
-    }
-    auto last_e_mv_node { solution.get_tour(moving_vehicle).at(last_e_mv_i) };
-    if (last_e_mv_i == solution.get_tour(moving_vehicle).size() - 1) {
-        return distance(solution.get_coord(e_node), solution.get_coord(last_e_mv_node));
-    }
-    auto dt { e_time - last_e_mv };
-    auto mv_next_node { solution.get_tour(moving_vehicle).at(last_e_mv_i + 1) };
-    auto mv_next_coord { solution.get_coord(mv_next_node) };
-    auto mv_last_node { solution.get_tour(moving_vehicle).at(last_e_mv_i) };
-    auto mv_last_coord { solution.get_coord(mv_last_node) };
-    auto real_position { partial_coordinate(mv_last_coord, mv_next_coord, dt) };
-    return distance(real_position, solution.get_coord(e_node));
+    return distance(position_at(solution, moving_vehicle, e_time), solution.get_coord(e_node));
 }
 
 
 Coord real_position(const MTSPBC& solution, const uint32_t moving_vehicle, const uint32_t last_e_mv, const uint32_t last_e_mv_i, const uint32_t e_time) {
-    auto last_e_mv_node_1 { solution.get_tour(moving_vehicle).at(last_e_mv_i) };
-    auto dt_1 { e_time - last_e_mv };
-    auto mv_next_node_1 { solution.get_tour(moving_vehicle).at(last_e_mv_i + 1) };
-    auto mv_next_coord_1 { solution.get_coord(mv_next_node_1) };
-    auto mv_last_node_1 { solution.get_tour(moving_vehicle).at(last_e_mv_i) };
-    auto mv_last_coord_1 { solution.get_coord(mv_last_node_1) };
-    auto real_position_1 { partial_coordinate(mv_last_coord_1, mv_next_coord_1, dt_1) };
-    return real_position_1;
+    std::span<const uint32_t> tour { solution.tour_view(moving_vehicle) };
+    return partial_coordinate(solution.get_coord(tour[last_e_mv_i]), solution.get_coord(tour[last_e_mv_i + 1]), e_time - last_e_mv);
 }
 
 
 uint32_t distance(const MTSPBC& solution, const uint32_t event_index, const uint32_t moving_vehicle_1, const uint32_t moving_vehicle_2) {
-    auto event { solution.get_event(event_index) };
-    auto e_time { event.first };
-    auto e_vehicle { event.second };
-    auto e_node { solution.get_node_at_event(e_vehicle, e_time) };
-    if (moving_vehicle_1 == 2 && moving_vehicle_2 == 4 && e_time == 17 && e_vehicle == 2) {
-        int debug {};
-    }
+    auto [e_time, e_vehicle] = solution.get_event(event_index);
     if (moving_vehicle_1 == e_vehicle) {
         return distance(solution, event_index, moving_vehicle_2);
     }
     else if (moving_vehicle_2 == e_vehicle) {
         return distance(solution, event_index, moving_vehicle_1);
     }
-    auto mv_events_1 { solution.get_vehicle_events(moving_vehicle_1) };
-    auto mv_events_2 { solution.get_vehicle_events(moving_vehicle_2) };
-    uint32_t last_e_mv_1 { };
-    uint32_t last_e_mv_2 { };
-    uint32_t last_e_mv_i_1 { };
-    uint32_t last_e_mv_i_2 { };
-    for (uint32_t t { 0 }; t < mv_events_1.size(); t++) {
-        if (mv_events_1.at(t) > e_time) {
-            break;
-        }
-        last_e_mv_1 = mv_events_1.at(t);
-        last_e_mv_i_1 = t;
+    return distance(position_at(solution, moving_vehicle_1, e_time), position_at(solution, moving_vehicle_2, e_time));
+}
+
+
+/**
+ * @brief Largest distance among a set of points.
+ * @details Convex hull by monotone chain, then rotating calipers over
+ * the antipodal pairs of the hull: O(k log k) instead of the O(k^2) of
+ * comparing every pair. Both use the cross product in double, since the
+ * positions are fractional and orientation() truncates the area to an
+ * integer; collinear points are left out of the hull.
+ * @param points The points; reordered.
+ * @param hull Buffer for the hull, reused between calls.
+ * @return The largest distance(a, b) over the antipodal pairs.
+ */
+uint32_t max_separation(std::vector<Coord>& points, std::vector<Coord>& hull) {
+    const size_t n { points.size() };
+    if (n < 2) {
+        return 0;
     }
-    for (uint32_t t { 0 }; t < mv_events_2.size(); t++) {
-        if (mv_events_2.at(t) > e_time) {
-            break;
+    std::sort(points.begin(), points.end(), [](const Coord& a, const Coord& b) {
+        return a.pos_x < b.pos_x || (a.pos_x == b.pos_x && a.pos_y < b.pos_y);
+    });
+    // área orientada, exata para as posições fracionárias dos veículos
+    auto area { [](const Coord& a, const Coord& b, const Coord& c) {
+        return (b.pos_x - a.pos_x) * (c.pos_y - a.pos_y) - (b.pos_y - a.pos_y) * (c.pos_x - a.pos_x);
+    } };
+    hull.resize(2 * n);
+    size_t h { 0 };
+    for (size_t i { 0 }; i < n; i++) {                      // cadeia inferior
+        while (h >= 2 && area(hull[h - 2], hull[h - 1], points[i]) <= 0) {
+            h--;
         }
-        last_e_mv_2 = mv_events_2.at(t);
-        last_e_mv_i_2 = t;
+        hull[h++] = points[i];
     }
-    if (last_e_mv_i_1 == mv_events_1.size() - 1) {
-        uint32_t mv_1_last { solution.get_tour(moving_vehicle_1).back() };
-        if (last_e_mv_i_2 == mv_events_2.size() - 1) {
-            uint32_t mv_2_last { solution.get_tour(moving_vehicle_2).back() };
-            return distance(solution.get_coord(mv_1_last), solution.get_coord(mv_2_last));
-        }
-        else {
-            Coord mv_2_real { real_position(solution, moving_vehicle_2, last_e_mv_2, last_e_mv_i_2, e_time) };
-            return distance(solution.get_coord(mv_1_last), mv_2_real);
+    const size_t lower { h + 1 };
+    for (size_t i { n - 1 }; i-- > 0;) {                    // cadeia superior
+        while (h >= lower && area(hull[h - 2], hull[h - 1], points[i]) <= 0) {
+            h--;
         }
+        hull[h++] = points[i];
     }
-    else {
-        Coord mv_1_real { real_position(solution, moving_vehicle_1, last_e_mv_1, last_e_mv_i_1, e_time) };
-        if (last_e_mv_i_2 == mv_events_2.size() - 1) {
-            uint32_t mv_2_last { solution.get_tour(moving_vehicle_2).back() };
-            return distance(solution.get_coord(mv_2_last), mv_1_real);
-        }
-        else {
-            Coord mv_2_real { real_position(solution, moving_vehicle_2, last_e_mv_2, last_e_mv_i_2, e_time) };
-            return distance(mv_1_real, mv_2_real);
+    h--;                                                    // o último ponto repete o primeiro
+    if (h < 3) {
+        return distance(hull[0], hull[h - 1]);
+    }
+
+    // avança o ponto antipodal enquanto ele se afasta da aresta
+    uint32_t max_distance { 0 };
+    size_t j { 1 };
+    for (size_t i { 0 }; i < h; i++) {
+        const Coord& a { hull[i] };
+        const Coord& b { hull[(i + 1) % h] };
+        while (area(a, b, hull[(j + 1) % h]) > area(a, b, hull[j])) {
+            j = (j + 1) % h;
         }
+        max_distance = std::max({ max_distance, distance(a, hull[j]), distance(b, hull[j]) });
     }
-    return 0;
+    return max_distance;
 }
 
 
-uint32_t unassign(const std::vector<uint32_t>& nodes, std::vector<size_t>& un_nodes) {
+uint32_t unassign(std::span<const uint32_t> nodes, std::vector<size_t>& un_nodes) {
     int n_removed {};
     for (auto i : nodes) {
         for (uint32_t j{}; j < un_nodes.size(); j++) {
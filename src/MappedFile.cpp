@@ -0,0 +1,60 @@
+/**
+ * @file MappedFile.cpp
+ * @brief Class MappedFile implementation
+ * @details Read-only memory mapping of a whole file. The
+ * mapping lives as long as the object, so views handed out
+ * by the binary instance cache keep a shared_ptr to it.
+ */
+
+
+#include "MappedFile.hpp"
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+/**
+ * @brief Maps a file in memory.
+ * @details Opens the file and maps it read-only. An empty
+ * file gives an empty mapping.
+ * @param filepath The file to be mapped.
+ */
+MappedFile::MappedFile(const std::string& filepath)
+: data_(nullptr), size_(0) {
+    int fd { ::open(filepath.c_str(), O_RDONLY) };
+    if (fd < 0) {
+        throw std::runtime_error("error: could not open file " + filepath);
+    }
+    struct stat st {};
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("error: could not stat file " + filepath);
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ > 0) {
+        void* p { ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0) };
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("error: could not map file " + filepath);
+        }
+        data_ = static_cast<const std::byte*>(p);
+    }
+    ::close(fd);
+}
+
+
+MappedFile::~MappedFile() {
+    if (data_) {
+        ::munmap(const_cast<std::byte*>(data_), size_);
+    }
+}
+
+
+[[nodiscard]] const std::byte* MappedFile::data() const noexcept { return data_; }
+[[nodiscard]] size_t MappedFile::size() const noexcept { return size_; }
+[[nodiscard]] std::span<const std::byte> MappedFile::bytes() const noexcept { return { data_, size_ }; }
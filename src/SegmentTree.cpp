@@ -0,0 +1,156 @@
+/**
+ * @file SegmentTree.cpp
+ * @brief Class SegmentTree implementation
+ * @details Iterative segment tree over the separation at every
+ * event of the timeline, keeping the max and the sum of each
+ * range. A point update or a range query is O(log E); replacing
+ * the values from some index on only visits the ancestors of the
+ * replaced leaves.
+ */
+
+
+#include "SegmentTree.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+
+/**
+ * @brief Constructor of the SegmentTree class.
+ * @details Initialize with no values.
+ */
+SegmentTree::SegmentTree()
+: size_(0), capacity_(0) {}
+
+
+void SegmentTree::pull_(const size_t p) noexcept {
+    max_[p] = std::max(max_[2 * p], max_[2 * p + 1]);
+    sum_[p] = sum_[2 * p] + sum_[2 * p + 1];
+}
+
+
+/**
+ * @brief Builds the tree over a sequence of values, in O(E).
+ * @param values The separation at every event.
+ */
+void SegmentTree::assign(std::span<const uint32_t> values) {
+    size_ = values.size();
+    capacity_ = std::bit_ceil(std::max<size_t>(size_, 1));
+    max_.assign(2 * capacity_, 0);
+    sum_.assign(2 * capacity_, 0);
+    for (size_t i { 0 }; i < size_; i++) {
+        max_[capacity_ + i] = values[i];
+        sum_[capacity_ + i] = values[i];
+    }
+    for (size_t p { capacity_ - 1 }; p > 0; p--) {
+        pull_(p);
+    }
+}
+
+
+/**
+ * @brief Replaces the values from first on.
+ * @details Values before first are kept and the size becomes
+ * first + values.size(). Only the ancestors of the leaves that
+ * change are recomputed, level by level, so a change confined to
+ * the end of the timeline costs O(m + log E) for m values; the
+ * tree is only rebuilt when it outgrows its capacity.
+ * @param first First index to replace, at most size().
+ * @param values The new values from first on.
+ */
+void SegmentTree::assign_suffix(const size_t first, std::span<const uint32_t> values) {
+    if (first > size_) {
+        throw std::out_of_range("error: index out of range");
+    }
+    const size_t new_size { first + values.size() };
+    if (new_size > capacity_) {
+        std::vector<uint32_t> all(new_size);
+        for (size_t i { 0 }; i < first; i++) {
+            all[i] = max_[capacity_ + i];
+        }
+        std::copy(values.begin(), values.end(), all.begin() + first);
+        assign(all);
+        return;
+    }
+    const size_t last { std::max(size_, new_size) };
+    for (size_t i { first }; i < last; i++) {
+        const uint32_t value { (i < new_size) ? values[i - first] : 0 };
+        max_[capacity_ + i] = value;
+        sum_[capacity_ + i] = value;
+    }
+    size_ = new_size;
+    if (first == last) {
+        return;
+    }
+    // sobe nível a nível refazendo só os pais das folhas alteradas
+    for (size_t lo { (capacity_ + first) / 2 }, hi { (capacity_ + last - 1) / 2 }; lo > 0; lo /= 2, hi /= 2) {
+        for (size_t p { lo }; p <= hi; p++) {
+            pull_(p);
+        }
+    }
+}
+
+
+void SegmentTree::set(const size_t i, const uint32_t value) {
+    if (i >= size_) {
+        throw std::out_of_range("error: index out of range");
+    }
+    size_t p { capacity_ + i };
+    max_[p] = value;
+    sum_[p] = value;
+    for (p /= 2; p > 0; p /= 2) {
+        pull_(p);
+    }
+}
+
+
+/**
+ * @brief Largest value in [first, last).
+ * @return The maximum, 0 for an empty range.
+ */
+[[nodiscard]] uint32_t SegmentTree::max(const size_t first, const size_t last) const {
+    if (first > last || last > size_) {
+        throw std::out_of_range("error: invalid interval");
+    }
+    uint32_t best { 0 };
+    for (size_t lo { capacity_ + first }, hi { capacity_ + last }; lo < hi; lo /= 2, hi /= 2) {
+        if (lo & 1) {
+            best = std::max(best, max_[lo++]);
+        }
+        if (hi & 1) {
+            best = std::max(best, max_[--hi]);
+        }
+    }
+    return best;
+}
+
+
+// soma de [first, last)
+[[nodiscard]] uint64_t SegmentTree::sum(const size_t first, const size_t last) const {
+    if (first > last || last > size_) {
+        throw std::out_of_range("error: invalid interval");
+    }
+    uint64_t total { 0 };
+    for (size_t lo { capacity_ + first }, hi { capacity_ + last }; lo < hi; lo /= 2, hi /= 2) {
+        if (lo & 1) {
+            total += sum_[lo++];
+        }
+        if (hi & 1) {
+            total += sum_[--hi];
+        }
+    }
+    return total;
+}
+
+
+[[nodiscard]] uint32_t SegmentTree::at(const size_t i) const {
+    if (i >= size_) {
+        throw std::out_of_range("error: index out of range");
+    }
+    return max_[capacity_ + i];
+}
+[[nodiscard]] size_t SegmentTree::size() const noexcept { return size_; }
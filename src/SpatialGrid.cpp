@@ -0,0 +1,280 @@
+/**
+ * @file SpatialGrid.cpp
+ * @brief Class SpatialGrid implementation
+ * @details Uniform grid over the node coordinates. Nodes are
+ * bucketed by cell in a CSR layout, so a query only looks at
+ * the nodes of the cells it overlaps instead of every node.
+ * Supports radius, k-nearest and segment-proximity queries.
+ */
+
+
+#include "SpatialGrid.hpp"
+#include "MTSPBC_ds.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+
+/**
+ * @brief Constructor of the SpatialGrid class.
+ * @details Initialize an empty grid.
+ */
+SpatialGrid::SpatialGrid()
+: min_x_(0), min_y_(0), cell_size_(1), n_cols_(1), n_rows_(1), cell_offsets_(2, 0) {}
+
+
+/**
+ * @brief Builds the grid over a set of coordinates.
+ * @param coordinates The node coordinates, indexed by node.
+ * @param cell_size Side of a square cell; the cover radius
+ * is a good choice for cover and radius queries.
+ */
+SpatialGrid::SpatialGrid(const std::vector<Coord>& coordinates, const double cell_size)
+: coordinates_(coordinates) {
+    if (!(cell_size > 0)) {
+        throw std::logic_error("error: grid cell size must be positive");
+    }
+    cell_size_ = cell_size;
+    min_x_ = 0;
+    min_y_ = 0;
+    double max_x { 0 };
+    double max_y { 0 };
+    if (!coordinates_.empty()) {
+        min_x_ = max_x = coordinates_.front().pos_x;
+        min_y_ = max_y = coordinates_.front().pos_y;
+    }
+    for (const auto& c : coordinates_) {
+        min_x_ = std::min(min_x_, c.pos_x);
+        min_y_ = std::min(min_y_, c.pos_y);
+        max_x = std::max(max_x, c.pos_x);
+        max_y = std::max(max_y, c.pos_y);
+    }
+    // limita o número de células a O(n) para raios pequenos em mapas grandes
+    double side { std::max(max_x - min_x_, max_y - min_y_) };
+    double max_cells { 4.0 * static_cast<double>(std::max<size_t>(coordinates_.size(), 1)) };
+    if ((side / cell_size_) * (side / cell_size_) > max_cells) {
+        cell_size_ = side / std::sqrt(max_cells);
+    }
+    n_cols_ = static_cast<uint32_t>((max_x - min_x_) / cell_size_) + 1;
+    n_rows_ = static_cast<uint32_t>((max_y - min_y_) / cell_size_) + 1;
+
+    cell_offsets_.assign(static_cast<size_t>(n_cols_) * n_rows_ + 1, 0);
+    std::vector<uint32_t> node_cell(coordinates_.size());
+    for (uint32_t i { 0 }; i < coordinates_.size(); i++) {
+        node_cell[i] = row_(coordinates_[i].pos_y) * n_cols_ + col_(coordinates_[i].pos_x);
+        cell_offsets_[node_cell[i] + 1]++;
+    }
+    for (size_t c { 1 }; c < cell_offsets_.size(); c++) {
+        cell_offsets_[c] += cell_offsets_[c - 1];
+    }
+    cell_nodes_.resize(coordinates_.size());
+    std::vector<uint32_t> fill { cell_offsets_.begin(), cell_offsets_.end() - 1 };
+    for (uint32_t i { 0 }; i < coordinates_.size(); i++) {
+        cell_nodes_[fill[node_cell[i]]++] = i;
+    }
+}
+
+
+uint32_t SpatialGrid::col_(const double x) const noexcept {
+    double c { std::floor((x - min_x_) / cell_size_) };
+    return static_cast<uint32_t>(std::clamp(c, 0.0, static_cast<double>(n_cols_ - 1)));
+}
+
+
+uint32_t SpatialGrid::row_(const double y) const noexcept {
+    double r { std::floor((y - min_y_) / cell_size_) };
+    return static_cast<uint32_t>(std::clamp(r, 0.0, static_cast<double>(n_rows_ - 1)));
+}
+
+
+/**
+ * @brief Candidate nodes near a segment.
+ * @details Appends to out every node of the cells that may hold
+ * points within radius of segment [a, b]. Row by row, only the
+ * columns reached by the part of the segment within radius of the
+ * row are visited, so a long edge walks its corridor of cells
+ * instead of its whole bounding box; a cell is kept if its center
+ * is within radius plus half a cell diagonal of the segment. It is
+ * a superset of the nodes within radius, to be filtered by an
+ * exact test.
+ * @return Number of cells visited.
+ */
+uint32_t SpatialGrid::segment_candidates(const Coord& a, const Coord& b, const double radius, std::vector<uint32_t>& out) const {
+    uint32_t r0 { row_(std::min(a.pos_y, b.pos_y) - radius) };
+    uint32_t r1 { row_(std::max(a.pos_y, b.pos_y) + radius) };
+    Coord ab { b - a };
+    double ab_2 { ab.pos_x * ab.pos_x + ab.pos_y * ab.pos_y };
+    double reach { radius + cell_size_ * 0.7072 };     // meia diagonal da célula, arredondada para cima
+    double reach_2 { reach * reach };
+    double margin { radius + cell_size_ * 1e-9 };      // folga para pontos na borda de uma linha
+    uint32_t visited { 0 };
+    for (uint32_t r { r0 }; r <= r1; r++) {
+        // trecho do segmento com y a até radius da faixa da linha r
+        double y_lo { min_y_ + r * cell_size_ - margin };
+        double y_hi { min_y_ + (r + 1) * cell_size_ + margin };
+        double t_lo { 0.0 };
+        double t_hi { 1.0 };
+        if (ab.pos_y != 0) {
+            double t_a { (y_lo - a.pos_y) / ab.pos_y };
+            double t_b { (y_hi - a.pos_y) / ab.pos_y };
+            t_lo = std::max(t_lo, std::min(t_a, t_b));
+            t_hi = std::min(t_hi, std::max(t_a, t_b));
+            if (t_lo > t_hi) {
+                continue;
+            }
+        } else if (a.pos_y < y_lo || a.pos_y > y_hi) {
+            continue;
+        }
+        double x_a { a.pos_x + ab.pos_x * t_lo };
+        double x_b { a.pos_x + ab.pos_x * t_hi };
+        uint32_t c0 { col_(std::min(x_a, x_b) - margin) };
+        uint32_t c1 { col_(std::max(x_a, x_b) + margin) };
+        for (uint32_t c { c0 }; c <= c1; c++) {
+            visited++;
+            size_t cell { static_cast<size_t>(r) * n_cols_ + c };
+            if (cell_offsets_[cell] == cell_offsets_[cell + 1]) {
+                continue;
+            }
+            Coord center { min_x_ + (c + 0.5) * cell_size_, min_y_ + (r + 0.5) * cell_size_ };
+            Coord ap { center - a };
+            double t { (ab_2 > 0) ? std::clamp((ap.pos_x * ab.pos_x + ap.pos_y * ab.pos_y) / ab_2, 0.0, 1.0) : 0.0 };
+            Coord d { ap - ab * t };
+            if (d.pos_x * d.pos_x + d.pos_y * d.pos_y > reach_2) {
+                continue;
+            }
+            out.insert(out.end(), cell_nodes_.begin() + cell_offsets_[cell], cell_nodes_.begin() + cell_offsets_[cell + 1]);
+        }
+    }
+    return visited;
+}
+
+
+// distância de um ponto à célula (col, row), zero se o ponto está dentro dela
+double SpatialGrid::cell_gap_(const Coord& point, const uint32_t col, const uint32_t row) const noexcept {
+    double x0 { min_x_ + col * cell_size_ };
+    double y0 { min_y_ + row * cell_size_ };
+    double dx { std::max({ x0 - point.pos_x, 0.0, point.pos_x - (x0 + cell_size_) }) };
+    double dy { std::max({ y0 - point.pos_y, 0.0, point.pos_y - (y0 + cell_size_) }) };
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+
+/**
+ * @brief Nodes within a radius of a point.
+ * @details Only the cells of the bounding box of the circle are
+ * visited. Appends to out, sorted by node, every node whose
+ * Euclidean distance to point is at most radius.
+ */
+void SpatialGrid::within_radius(const Coord& point, const double radius, std::vector<uint32_t>& out) const {
+    size_t first { out.size() };
+    double radius_2 { radius * radius };
+    uint32_t c0 { col_(point.pos_x - radius) };
+    uint32_t c1 { col_(point.pos_x + radius) };
+    uint32_t r0 { row_(point.pos_y - radius) };
+    uint32_t r1 { row_(point.pos_y + radius) };
+    for (uint32_t r { r0 }; r <= r1; r++) {
+        for (uint32_t c { c0 }; c <= c1; c++) {
+            size_t cell { static_cast<size_t>(r) * n_cols_ + c };
+            for (uint32_t s { cell_offsets_[cell] }; s < cell_offsets_[cell + 1]; s++) {
+                Coord d { coordinates_[cell_nodes_[s]] - point };
+                if (d.pos_x * d.pos_x + d.pos_y * d.pos_y <= radius_2) {
+                    out.push_back(cell_nodes_[s]);
+                }
+            }
+        }
+    }
+    std::sort(out.begin() + first, out.end());
+}
+
+
+/**
+ * @brief Nodes within a radius of a segment.
+ * @details Exact filter over segment_candidates. Appends to out,
+ * sorted by node, every node whose Euclidean distance to segment
+ * [a, b] is at most radius, i.e. the nodes the edge can cover.
+ */
+void SpatialGrid::near_segment(const Coord& a, const Coord& b, const double radius, std::vector<uint32_t>& out) const {
+    size_t first { out.size() };
+    segment_candidates(a, b, radius, out);
+    Coord ab { b - a };
+    double ab_2 { ab.pos_x * ab.pos_x + ab.pos_y * ab.pos_y };
+    double radius_2 { radius * radius };
+    auto far { [&](const uint32_t node) {
+        Coord ap { coordinates_[node] - a };
+        double t { (ab_2 > 0) ? std::clamp((ap.pos_x * ab.pos_x + ap.pos_y * ab.pos_y) / ab_2, 0.0, 1.0) : 0.0 };
+        Coord d { ap - ab * t };
+        return d.pos_x * d.pos_x + d.pos_y * d.pos_y > radius_2;
+    } };
+    out.erase(std::remove_if(out.begin() + first, out.end(), far), out.end());
+    std::sort(out.begin() + first, out.end());
+}
+
+
+/**
+ * @brief The k nodes nearest to a point.
+ * @details Visits rings of cells around the cell of point, from
+ * the inside out, and stops once no unvisited cell can hold a node
+ * closer than the k-th best. Appends to out the min(k, n) nearest
+ * nodes, closest first and ties broken by node index.
+ */
+void SpatialGrid::nearest(const Coord& point, const uint32_t k, std::vector<uint32_t>& out) const {
+    const size_t want { std::min<size_t>(k, coordinates_.size()) };
+    if (want == 0) {
+        return;
+    }
+    const uint32_t c0 { col_(point.pos_x) };
+    const uint32_t r0 { row_(point.pos_y) };
+    const double gap { cell_gap_(point, c0, r0) };
+    const uint32_t max_ring { std::max({ c0, n_cols_ - 1 - c0, r0, n_rows_ - 1 - r0 }) };
+    std::vector<std::pair<double, uint32_t>> best {};        // max-heap dos k melhores (distância², nó)
+    best.reserve(want + 1);
+
+    auto visit { [&](const uint32_t c, const uint32_t r) {
+        size_t cell { static_cast<size_t>(r) * n_cols_ + c };
+        for (uint32_t s { cell_offsets_[cell] }; s < cell_offsets_[cell + 1]; s++) {
+            Coord d { coordinates_[cell_nodes_[s]] - point };
+            std::pair<double, uint32_t> item { d.pos_x * d.pos_x + d.pos_y * d.pos_y, cell_nodes_[s] };
+            if (best.size() < want) {
+                best.push_back(item);
+                std::push_heap(best.begin(), best.end());
+            } else if (item < best.front()) {
+                std::pop_heap(best.begin(), best.end());
+                best.back() = item;
+                std::push_heap(best.begin(), best.end());
+            }
+        }
+    } };
+
+    for (uint32_t ring { 0 }; ring <= max_ring; ring++) {
+        int64_t lo_c { static_cast<int64_t>(c0) - ring };
+        int64_t hi_c { static_cast<int64_t>(c0) + ring };
+        int64_t lo_r { static_cast<int64_t>(r0) - ring };
+        int64_t hi_r { static_cast<int64_t>(r0) + ring };
+        for (int64_t r { std::max<int64_t>(lo_r, 0) }; r <= std::min<int64_t>(hi_r, n_rows_ - 1); r++) {
+            bool edge_row { r == lo_r || r == hi_r };
+            for (int64_t c { std::max<int64_t>(lo_c, 0) }; c <= std::min<int64_t>(hi_c, n_cols_ - 1); c++) {
+                if (edge_row || c == lo_c || c == hi_c) {
+                    visit(static_cast<uint32_t>(c), static_cast<uint32_t>(r));
+                }
+            }
+        }
+        // células ainda não visitadas estão a pelo menos ring * cell_size da célula central
+        double reach { ring * cell_size_ - gap };
+        if (best.size() == want && reach > 0 && best.front().first <= reach * reach) {
+            break;
+        }
+    }
+    std::sort_heap(best.begin(), best.end());
+    for (const auto& [d_2, node] : best) {
+        out.push_back(node);
+    }
+}
+
+
+[[nodiscard]] double SpatialGrid::cell_size() const noexcept { return cell_size_; }
+[[nodiscard]] uint32_t SpatialGrid::n() const noexcept { return coordinates_.size(); }
+[[nodiscard]] size_t SpatialGrid::n_cells() const noexcept { return cell_offsets_.size() - 1; }
@@ -0,0 +1,98 @@
+/**
+ * @file TextParser.cpp
+ * @brief Parallel parsers for the pre-processing text files
+ * @details inst.dat and cover.dat are mapped in memory, split
+ * in chunks on line boundaries and parsed on all cores with
+ * std::from_chars, instead of getline plus stringstream.
+ */
+
+
+#include "TextParser.hpp"
+#include "CostMatrix.hpp"
+#include "CoverIndex.hpp"
+#include "MappedFile.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+/**
+ * @brief Parses the distance file into a cost matrix.
+ * @details The first non-comment line is a header and is
+ * skipped; every other line is "node_A node_B distance".
+ * @param dist_filepath Path of inst.dat.
+ * @param cost_matrix Matrix already sized for the instance.
+ */
+void parse_dist_file(const std::string& dist_filepath, CostMatrix& cost_matrix) {
+    MappedFile file(dist_filepath);
+    std::string_view text { reinterpret_cast<const char*>(file.data()), file.size() };
+
+    // pula comentários e a linha de cabeçalho
+    text = skip_header_line(text);
+
+    const uint32_t n { cost_matrix.n() };
+    parallel_for_lines(text, [&](const size_t, std::string_view line) {
+        LineReader reader(line);
+        if (reader.blank()) {
+            return;
+        }
+        uint32_t node_A {};
+        uint32_t node_B {};
+        uint32_t dist_AB {};
+        if (!reader.read(node_A) || !reader.read(node_B) || !reader.read(dist_AB)) {
+            throw std::runtime_error("error: malformed line in " + dist_filepath + ": " + std::string(line));
+        }
+        if (node_A >= n || node_B >= n) {
+            throw std::out_of_range("error: distance entry references a node that does not exist");
+        }
+        cost_matrix.set(node_A, node_B, dist_AB);
+    });
+}
+
+
+/**
+ * @brief Parses the cover file.
+ * @details Every line is "covered departure arrival LB UB".
+ * Only covering triples (LB <= UB) are returned, in file order.
+ * @param cover_filepath Path of cover.dat.
+ * @param n_nodes Number of nodes of the instance.
+ * @return The covering triples.
+ */
+std::vector<CoverTriple> parse_cover_file(const std::string& cover_filepath, const uint32_t n_nodes) {
+    MappedFile file(cover_filepath);
+    std::string_view text { reinterpret_cast<const char*>(file.data()), file.size() };
+    std::vector<std::vector<CoverTriple>> chunk_triples(line_chunk_count(text.size()));
+
+    size_t n_chunks { parallel_for_lines(text, [&](const size_t chunk, std::string_view line) {
+        LineReader reader(line);
+        if (reader.blank()) {
+            return;
+        }
+        CoverTriple t {};
+        if (!reader.read(t.covered_node) || !reader.read(t.departure_node) || !reader.read(t.arrival_node)
+            || !reader.read(t.LB) || !reader.read(t.UB)) {
+            throw std::runtime_error("error: malformed line in " + cover_filepath + ": " + std::string(line));
+        }
+        if (t.covered_node >= n_nodes || t.departure_node >= n_nodes || t.arrival_node >= n_nodes) {
+            throw std::out_of_range("error: cover triple references a node that does not exist");
+        }
+        if (t.LB <= t.UB) {
+            chunk_triples[chunk].push_back(t);
+        }
+    }, chunk_triples.size()) };
+
+    size_t total { 0 };
+    for (size_t c { 0 }; c < n_chunks; c++) {
+        total += chunk_triples[c].size();
+    }
+    std::vector<CoverTriple> triples {};
+    triples.reserve(total);
+    for (size_t c { 0 }; c < n_chunks; c++) {
+        triples.insert(triples.end(), chunk_triples[c].begin(), chunk_triples[c].end());
+    }
+    return triples;
+}
@@ -0,0 +1,255 @@
+/**
+ * @file Trajectories.cpp
+ * @brief Batched vehicle position interpolation
+ * @details The tours of every vehicle are kept as SoA arrays of
+ * edges: start point, unit vector and start event. Positions of
+ * all vehicles at a block of times are interpolated in one call,
+ * with no norm or division per position. Every position is
+ * bit-identical to partial_coordinate: the unit vector is the
+ * same mn / coord_norm(mn), and the position is start + unit * dt
+ * without fused multiply-add.
+ */
+
+
+#include "Trajectories.hpp"
+#include "MTSPBCInstance.hpp"
+#include "MTSPBC_ds.hpp"
+#include "MTSPBC_util.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+
+namespace {
+
+void advance_scalar(const double* sx, const double* ux, const double* dt, const size_t begin, const size_t m, double* out) {
+    for (size_t j { begin }; j < m; j++) {
+        double step { ux[j] * dt[j] };
+        out[j] = sx[j] + step;
+    }
+}
+
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+void advance_avx2(const double* sx, const double* ux, const double* dt, const size_t m, double* out) {
+    size_t j { 0 };
+    for (; j + 4 <= m; j += 4) {
+        __m256d step { _mm256_mul_pd(_mm256_loadu_pd(ux + j), _mm256_loadu_pd(dt + j)) };
+        _mm256_storeu_pd(out + j, _mm256_add_pd(_mm256_loadu_pd(sx + j), step));
+    }
+    advance_scalar(sx, ux, dt, j, m, out);
+}
+
+
+bool has_avx2() {
+    static const bool supported { __builtin_cpu_supports("avx2") != 0 };
+    return supported;
+}
+#endif
+
+
+// out = start + unit * dt, 4 posições por instrução quando a CPU tem AVX2
+void advance(const double* sx, const double* ux, const double* dt, const size_t m, double* out) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (has_avx2()) {
+        advance_avx2(sx, ux, dt, m, out);
+        return;
+    }
+#endif
+    advance_scalar(sx, ux, dt, 0, m, out);
+}
+
+}
+
+
+/**
+ * @brief Constructor of the Trajectories class.
+ * @details Initialize with no vehicles.
+ */
+Trajectories::Trajectories()
+: offsets_(1, 0) {}
+
+
+/**
+ * @brief Precomputes the edges of every vehicle.
+ * @details A tour of n nodes gives n edges: one per pair of
+ * consecutive nodes and a last one, with a zero unit vector, that
+ * keeps the vehicle at its last node.
+ * @param tours Node sequence of every vehicle.
+ * @param events Event times of every vehicle.
+ */
+void Trajectories::assign(const std::vector<std::span<const uint32_t>>& tours, const std::vector<std::span<const uint32_t>>& events,
+                          const MTSPBCInstance& instance) {
+    if (tours.size() != events.size()) {
+        throw std::logic_error("error: tours and events do not match");
+    }
+    offsets_.assign(1, 0);
+    start_time_.clear();
+    start_x_.clear();
+    start_y_.clear();
+    unit_x_.clear();
+    unit_y_.clear();
+    for (size_t v { 0 }; v < tours.size(); v++) {
+        std::span<const uint32_t> tour { tours[v] };
+        for (size_t i { 0 }; i < tour.size() && i < events[v].size(); i++) {
+            Coord m { instance.coordinate(tour[i]) };
+            Coord unit { 0, 0 };
+            if (i + 1 < tour.size()) {
+                Coord mn { instance.coordinate(tour[i + 1]) - m };
+                unit = mn / coord_norm(mn);
+            }
+            start_time_.push_back(events[v][i]);
+            start_x_.push_back(m.pos_x);
+            start_y_.push_back(m.pos_y);
+            unit_x_.push_back(unit.pos_x);
+            unit_y_.push_back(unit.pos_y);
+        }
+        offsets_.push_back(start_time_.size());
+    }
+}
+
+
+/**
+ * @brief Positions of every vehicle at a block of times.
+ * @details The edge of each vehicle is its last event at or before
+ * the time, found by moving the cursor forward, so times must not
+ * decrease across calls sharing a cursor. Edges are gathered in SoA
+ * blocks and interpolated together. A vehicle with no nodes is at
+ * (0, 0).
+ * @param times Non-decreasing times.
+ * @param cursor Edge of each vehicle, zeroed before the first block.
+ * @param xs, ys Positions, vehicle v at time q in [q * n_vehicles() + v].
+ */
+void Trajectories::interpolate(std::span<const uint32_t> times, std::span<uint32_t> cursor, double* xs, double* ys) const {
+    const uint32_t n_k { n_vehicles() };
+    if (cursor.size() < n_k) {
+        throw std::logic_error("error: cursor does not match the vehicles");
+    }
+    const size_t m { times.size() * n_k };
+    block_x_.resize(m);
+    block_y_.resize(m);
+    block_ux_.resize(m);
+    block_uy_.resize(m);
+    block_dt_.resize(m);
+    size_t j { 0 };
+    for (uint32_t e_time : times) {
+        for (uint32_t v { 0 }; v < n_k; v++, j++) {
+            const uint32_t first { offsets_[v] };
+            const uint32_t n_edges { offsets_[v + 1] - first };
+            if (n_edges == 0) {
+                block_x_[j] = block_y_[j] = block_ux_[j] = block_uy_[j] = block_dt_[j] = 0;
+                continue;
+            }
+            uint32_t& c { cursor[v] };
+            while (c + 1 < n_edges && start_time_[first + c + 1] <= e_time) {
+                c++;
+            }
+            const uint32_t edge { first + c };
+            block_x_[j] = start_x_[edge];
+            block_y_[j] = start_y_[edge];
+            block_ux_[j] = unit_x_[edge];
+            block_uy_[j] = unit_y_[edge];
+            block_dt_[j] = static_cast<double>(e_time - start_time_[edge]);
+        }
+    }
+    advance(block_x_.data(), block_ux_.data(), block_dt_.data(), m, xs);
+    advance(block_y_.data(), block_uy_.data(), block_dt_.data(), m, ys);
+}
+
+
+/**
+ * @brief Exact maximum separation of two vehicles in continuous time.
+ * @details The events of both vehicles cut time in intervals where
+ * each one moves along a single edge, so their squared separation is
+ * a quadratic in time with a non-negative leading term
+ * |u_1 - u_2|^2: its vertex is a minimum and the maximum over the
+ * interval is at one of its ends. Each interval is then checked at
+ * its start and at the limit of its end, where a vehicle may still
+ * be short of the next node, and an event instant at every node the
+ * vehicle visits then. One merge of the two event lists, with no
+ * sampling in between.
+ * @return The separation, the time it occurs or is approached, and
+ * the vehicles; 0 if either vehicle has no nodes.
+ */
+[[nodiscard]] ContinuousSeparation Trajectories::max_separation(const uint32_t vehicle_1, const uint32_t vehicle_2) const {
+    if (vehicle_1 >= n_vehicles() || vehicle_2 >= n_vehicles()) {
+        throw std::logic_error("error: vehicle does not exist");
+    }
+    ContinuousSeparation best { 0, 0, vehicle_1, vehicle_2 };
+    const uint32_t first_1 { offsets_[vehicle_1] };
+    const uint32_t end_1 { offsets_[vehicle_1 + 1] };
+    const uint32_t first_2 { offsets_[vehicle_2] };
+    const uint32_t end_2 { offsets_[vehicle_2 + 1] };
+    if (first_1 == end_1 || first_2 == end_2) {
+        return best;
+    }
+    double best_2 { -1 };
+    auto position { [&](const uint32_t edge, const uint32_t e_time) {
+        double dt { static_cast<double>(e_time - start_time_[edge]) };
+        return Coord { start_x_[edge] + unit_x_[edge] * dt, start_y_[edge] + unit_y_[edge] * dt };
+    } };
+    auto consider { [&](const Coord& a, const Coord& b, const uint32_t e_time) {
+        double dx { a.pos_x - b.pos_x };
+        double dy { a.pos_y - b.pos_y };
+        double d_2 { dx * dx + dy * dy };
+        if (d_2 > best_2) {
+            best_2 = d_2;
+            best.e_time = e_time;
+        }
+    } };
+    // aresta atual: a última que começa até e_time
+    auto advance { [&](uint32_t& edge, const uint32_t end, const uint32_t e_time) {
+        while (edge + 1 < end && start_time_[edge + 1] <= e_time) {
+            edge++;
+        }
+    } };
+    // arestas que começam exatamente em e_time: nós visitados nesse instante
+    auto first_at { [&](const uint32_t edge, const uint32_t first, const uint32_t e_time) {
+        uint32_t j { edge };
+        while (j > first && start_time_[j - 1] == e_time) {
+            j--;
+        }
+        return j;
+    } };
+
+    uint32_t edge_1 { first_1 };
+    uint32_t edge_2 { first_2 };
+    uint32_t e_time { std::max(start_time_[first_1], start_time_[first_2]) };
+    while (true) {
+        advance(edge_1, end_1, e_time);
+        advance(edge_2, end_2, e_time);
+        const bool at_node_1 { start_time_[edge_1] == e_time };
+        const bool at_node_2 { start_time_[edge_2] == e_time };
+        for (uint32_t i { at_node_1 ? first_at(edge_1, first_1, e_time) : edge_1 }; i <= edge_1; i++) {
+            for (uint32_t j { at_node_2 ? first_at(edge_2, first_2, e_time) : edge_2 }; j <= edge_2; j++) {
+                consider(position(i, e_time), position(j, e_time), e_time);
+            }
+        }
+        uint32_t next { UINT32_MAX };
+        if (edge_1 + 1 < end_1) {
+            next = start_time_[edge_1 + 1];
+        }
+        if (edge_2 + 1 < end_2) {
+            next = std::min(next, start_time_[edge_2 + 1]);
+        }
+        if (next == UINT32_MAX) {
+            break;
+        }
+        // limite pela esquerda do fim do intervalo, ainda nas arestas atuais
+        consider(position(edge_1, next), position(edge_2, next), next);
+        e_time = next;
+    }
+    best.value = std::sqrt(best_2);
+    return best;
+}
+
+
+[[nodiscard]] uint32_t Trajectories::n_vehicles() const noexcept { return offsets_.size() - 1; }
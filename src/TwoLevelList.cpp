@@ -0,0 +1,278 @@
+/**
+ * @file TwoLevelList.cpp
+ * @brief Class TwoLevelList implementation
+ * @details Two-level list of tour positions, in the style of
+ * the LKH tour segments: the tour is cut in about sqrt(n)
+ * segments, each an array of nodes with a reversal bit. A node
+ * is found by walking the segments, an insertion or removal
+ * only moves the nodes of one segment, and reversing a range
+ * splits at its ends and flips the order and the bits of the
+ * segments in between, so every operation is O(sqrt(n)).
+ * Positions, not nodes, are the keys, so a node (the depot)
+ * may appear more than once.
+ */
+
+
+#include "TwoLevelList.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+
+/**
+ * @brief Constructor of the TwoLevelList class.
+ * @details Initialize an empty list.
+ */
+TwoLevelList::TwoLevelList()
+: size_(0), target_(8) {}
+
+
+/**
+ * @brief Builds the list over a sequence of nodes.
+ * @param nodes The nodes, in tour order.
+ */
+TwoLevelList::TwoLevelList(std::span<const uint32_t> nodes)
+: size_(0), target_(8) {
+    assign(nodes);
+}
+
+
+// recorta a sequência em segmentos de tamanho alvo ~sqrt(n)
+void TwoLevelList::assign(std::span<const uint32_t> nodes) {
+    size_ = nodes.size();
+    target_ = std::max<size_t>(8, static_cast<size_t>(std::sqrt(static_cast<double>(size_))));
+    segments_.clear();
+    for (size_t first { 0 }; first < nodes.size(); first += target_) {
+        size_t last { std::min(nodes.size(), first + target_) };
+        segments_.push_back({ std::vector<uint32_t>(nodes.begin() + first, nodes.begin() + last), false });
+    }
+}
+
+
+void TwoLevelList::clear() noexcept {
+    segments_.clear();
+    size_ = 0;
+}
+
+
+// segmento e deslocamento lógico dentro dele de uma posição da rota
+std::pair<size_t, size_t> TwoLevelList::locate_(const size_t pos) const {
+    size_t offset { pos };
+    for (size_t s { 0 }; s < segments_.size(); s++) {
+        if (offset < segments_[s].nodes.size()) {
+            return { s, offset };
+        }
+        offset -= segments_[s].nodes.size();
+    }
+    throw std::out_of_range("error: position out of range");
+}
+
+
+size_t TwoLevelList::physical_(const Segment& segment, const size_t offset) const noexcept {
+    return segment.reversed ? segment.nodes.size() - 1 - offset : offset;
+}
+
+
+// desfaz o bit de inversão, invertendo os nós do segmento
+void TwoLevelList::normalize_(Segment& segment) {
+    if (segment.reversed) {
+        std::reverse(segment.nodes.begin(), segment.nodes.end());
+        segment.reversed = false;
+    }
+}
+
+
+/**
+ * @brief Splits the list so that a segment starts at pos.
+ * @details The segment holding pos is cut in two, keeping the
+ * reversal bit on both halves.
+ * @param pos A position in [0, size].
+ * @return Index of the segment that starts at pos, or the number
+ * of segments if pos is the end.
+ */
+size_t TwoLevelList::split_(const size_t pos) {
+    if (pos == size_) {
+        return segments_.size();
+    }
+    auto [s, offset] = locate_(pos);
+    if (offset == 0) {
+        return s;
+    }
+    Segment& segment { segments_[s] };
+    const size_t n { segment.nodes.size() };
+    Segment tail { {}, segment.reversed };
+    if (!segment.reversed) {
+        tail.nodes.assign(segment.nodes.begin() + offset, segment.nodes.end());
+        segment.nodes.resize(offset);
+    } else {
+        // invertido: as posições lógicas [0, offset) são as físicas [n - offset, n)
+        tail.nodes.assign(segment.nodes.begin(), segment.nodes.begin() + (n - offset));
+        segment.nodes.erase(segment.nodes.begin(), segment.nodes.begin() + (n - offset));
+    }
+    segments_.insert(segments_.begin() + s + 1, std::move(tail));
+    return s + 1;
+}
+
+
+// junta um segmento pequeno ao vizinho seguinte (ou anterior) para conter a fragmentação
+void TwoLevelList::merge_small_(const size_t seg) {
+    if (seg >= segments_.size() || segments_.size() < 2 || segments_[seg].nodes.size() * 2 >= target_) {
+        return;
+    }
+    size_t left { (seg + 1 < segments_.size()) ? seg : seg - 1 };
+    Segment& a { segments_[left] };
+    Segment& b { segments_[left + 1] };
+    if (a.nodes.size() + b.nodes.size() > 2 * target_) {
+        return;
+    }
+    normalize_(a);
+    normalize_(b);
+    a.nodes.insert(a.nodes.end(), b.nodes.begin(), b.nodes.end());
+    segments_.erase(segments_.begin() + left + 1);
+}
+
+
+// refaz os segmentos quando há segmentos demais, O(n) amortizado
+void TwoLevelList::rebuild_() {
+    std::vector<uint32_t> nodes;
+    flatten(nodes);
+    assign(nodes);
+}
+
+
+/**
+ * @brief Inserts a node before pos.
+ * @details Only the nodes of one segment move. A segment that
+ * grows past twice the target size is split in two.
+ * @param pos A position in [0, size]; size appends.
+ */
+void TwoLevelList::insert(const size_t pos, const uint32_t node) {
+    if (pos > size_) {
+        throw std::out_of_range("error: position out of range");
+    }
+    if (segments_.empty()) {
+        segments_.push_back({ { node }, false });
+        size_ = 1;
+        return;
+    }
+    size_t s { };
+    size_t offset { };
+    if (pos == size_) {
+        s = segments_.size() - 1;
+        offset = segments_[s].nodes.size();
+    } else {
+        std::tie(s, offset) = locate_(pos);
+    }
+    Segment& segment { segments_[s] };
+    size_t physical { segment.reversed ? segment.nodes.size() - offset : offset };
+    segment.nodes.insert(segment.nodes.begin() + physical, node);
+    size_++;
+    if (segment.nodes.size() > 2 * target_) {
+        split_(pos - offset + segment.nodes.size() / 2);
+    }
+}
+
+
+/**
+ * @brief Removes the node at pos.
+ * @details Only the nodes of one segment move; an emptied
+ * segment is dropped and a small one merged with a neighbour.
+ */
+void TwoLevelList::erase(const size_t pos) {
+    auto [s, offset] = locate_(pos);
+    Segment& segment { segments_[s] };
+    segment.nodes.erase(segment.nodes.begin() + physical_(segment, offset));
+    size_--;
+    if (segment.nodes.empty()) {
+        segments_.erase(segments_.begin() + s);
+        return;
+    }
+    merge_small_(s);
+}
+
+
+/**
+ * @brief Reverses the positions [pos_i, pos_e).
+ * @details Splits at both ends, then reverses the order of the
+ * segments in between and flips their reversal bits; no node
+ * moves except at the two split points.
+ */
+void TwoLevelList::reverse(const size_t pos_i, const size_t pos_e) {
+    if (pos_i > pos_e || pos_e > size_) {
+        throw std::out_of_range("error: invalid interval");
+    }
+    if (pos_e - pos_i < 2) {
+        return;
+    }
+    size_t first { split_(pos_i) };
+    size_t last { split_(pos_e) };
+    std::reverse(segments_.begin() + first, segments_.begin() + last);
+    for (size_t s { first }; s < last; s++) {
+        segments_[s].reversed = !segments_[s].reversed;
+    }
+    merge_small_(last);
+    merge_small_(first);
+    if (first > 0) {
+        merge_small_(first - 1);
+    }
+    if (segments_.size() > 4 * (size_ / target_ + 1)) {
+        rebuild_();
+    }
+}
+
+
+// copia os nós na ordem da rota
+void TwoLevelList::flatten(std::vector<uint32_t>& out) const {
+    out.resize(size_);
+    auto it { out.begin() };
+    for (const auto& segment : segments_) {
+        if (segment.reversed) {
+            it = std::copy(segment.nodes.rbegin(), segment.nodes.rend(), it);
+        } else {
+            it = std::copy(segment.nodes.begin(), segment.nodes.end(), it);
+        }
+    }
+}
+
+
+// copia os nós de [pos_i, pos_e) na ordem da rota, em O(sqrt(n) + pos_e - pos_i)
+void TwoLevelList::copy_range(const size_t pos_i, const size_t pos_e, std::vector<uint32_t>& out) const {
+    if (pos_i > pos_e || pos_e > size_) {
+        throw std::out_of_range("error: invalid interval");
+    }
+    out.clear();
+    if (pos_i == pos_e) {
+        return;
+    }
+    auto [s, offset] = locate_(pos_i);
+    for (; out.size() < pos_e - pos_i; s++, offset = 0) {
+        const Segment& segment { segments_[s] };
+        const size_t last { std::min(segment.nodes.size(), offset + (pos_e - pos_i - out.size())) };
+        for (size_t q { offset }; q < last; q++) {
+            out.push_back(segment.nodes[physical_(segment, q)]);
+        }
+    }
+}
+
+
+[[nodiscard]] uint32_t TwoLevelList::at(const size_t pos) const {
+    auto [s, offset] = locate_(pos);
+    return segments_[s].nodes[physical_(segments_[s], offset)];
+}
+[[nodiscard]] uint32_t TwoLevelList::front() const { return at(0); }
+[[nodiscard]] uint32_t TwoLevelList::back() const {
+    if (size_ == 0) {
+        throw std::out_of_range("error: empty list");
+    }
+    const Segment& segment { segments_.back() };
+    return segment.reversed ? segment.nodes.front() : segment.nodes.back();
+}
+[[nodiscard]] size_t TwoLevelList::size() const noexcept { return size_; }
+[[nodiscard]] bool TwoLevelList::empty() const noexcept { return size_ == 0; }
+[[nodiscard]] size_t TwoLevelList::n_segments() const noexcept { return segments_.size(); }
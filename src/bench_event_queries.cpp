@@ -0,0 +1,170 @@
+/**
+ * @file bench_event_queries.cpp
+ * @brief Microbenchmark of the event queries
+ * @details Times the event lookups of Cht and the distance kernels
+ * of MTSPBC_util against the linear scans they replaced, on
+ * synthetic tours of growing length, and max_separation against
+ * every pair on fleets of growing size. Prints nanoseconds per query.
+ * Usage: bench_event_queries [queries]
+ */
+
+
+#include "MTSPBC.hpp"
+#include "MTSPBCInstance.hpp"
+#include "MTSPBC_util.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+
+namespace {
+
+// gerador determinístico, para que as execuções sejam comparáveis
+uint32_t next_random(uint64_t& state) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return static_cast<uint32_t>(state >> 33);
+}
+
+
+// versões com varredura linear e cópias, como eram antes das buscas binárias
+uint32_t linear_event_index(const std::vector<uint32_t>& events, const uint32_t e_time) {
+    if (e_time > events.back()) {
+        return events.size() - 1;
+    }
+    return std::distance(events.begin(), std::find(events.begin(), events.end(), e_time));
+}
+
+
+size_t linear_edge_at_event(const std::vector<uint32_t>& events, const uint32_t e_time) {
+    for (uint32_t i { 1 }; i < events.size(); i++) {
+        if (events.at(i) > e_time) {
+            return i - 1;
+        }
+    }
+    return events.size() - 2;
+}
+
+
+Coord linear_position_at(const MTSPBC& solution, const uint32_t vehicle, const uint32_t e_time) {
+    auto events { solution.get_vehicle_events(vehicle) };
+    uint32_t last_e { };
+    uint32_t last_e_i { };
+    for (uint32_t t { 0 }; t < events.size(); t++) {
+        if (events.at(t) > e_time) {
+            break;
+        }
+        last_e = events.at(t);
+        last_e_i = t;
+    }
+    if (last_e_i == solution.get_tour(vehicle).size() - 1) {
+        return solution.get_coord(solution.get_tour(vehicle).back());
+    }
+    return partial_coordinate(solution.get_coord(solution.get_tour(vehicle).at(last_e_i)),
+                              solution.get_coord(solution.get_tour(vehicle).at(last_e_i + 1)), e_time - last_e);
+}
+
+
+uint32_t all_pairs_separation(const std::vector<Coord>& points) {
+    uint32_t max_distance { 0 };
+    for (size_t k { 0 }; k + 1 < points.size(); k++) {
+        for (size_t l { k + 1 }; l < points.size(); l++) {
+            max_distance = std::max(max_distance, distance(points[k], points[l]));
+        }
+    }
+    return max_distance;
+}
+
+
+template <typename Fn>
+double ns_per_query(const std::vector<uint32_t>& times, Fn&& fn) {
+    uint64_t sink { 0 };
+    auto start { std::chrono::steady_clock::now() };
+    for (uint32_t t : times) {
+        sink += fn(t);
+    }
+    auto elapsed { std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() };
+    static volatile uint64_t keep { 0 };
+    keep = keep + sink;                         // impede que o compilador descarte as consultas
+    return elapsed / times.size();
+}
+
+}
+
+
+int main(int argc, char** argv) {
+    const size_t n_queries { (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 20000 };
+    constexpr uint32_t n_nodes { 1000 };
+    constexpr uint32_t k_vehicles { 2 };
+    uint64_t state { 42 };
+    std::vector<Coord> coordinates(n_nodes);
+    for (auto& c : coordinates) {
+        c = { static_cast<double>(next_random(state) % 10000), static_cast<double>(next_random(state) % 10000) };
+    }
+    MTSPBCInstance instance(std::move(coordinates), k_vehicles, 500);
+
+    std::cout << std::setw(8) << "nodes" << std::setw(14) << "query" << std::setw(12) << "linear ns"
+              << std::setw(12) << "binary ns" << std::setw(10) << "speedup" << std::endl;
+    for (uint32_t tour_size : { 200u, 800u, 3200u, 12800u }) {
+        MTSPBC solution(instance);
+        for (uint32_t k { 0 }; k < k_vehicles; k++) {
+            solution.create_vehicle();
+            solution.push_back(k, 0);
+            for (uint32_t i { 1 }; i + 1 < tour_size; i++) {
+                solution.push_back(k, 1 + next_random(state) % (n_nodes - 1));
+            }
+            solution.push_back(k, 0);
+        }
+        std::vector<uint32_t> events { solution.get_vehicle_events(0) };
+        std::vector<uint32_t> event_times(n_queries);
+        std::vector<uint32_t> any_times(n_queries);
+        for (size_t q { 0 }; q < n_queries; q++) {
+            event_times[q] = events[next_random(state) % events.size()];
+            any_times[q] = next_random(state) % (events.back() + 1);
+        }
+        auto report { [&](const char* query, const double linear, const double binary) {
+            std::cout << std::setw(8) << tour_size << std::setw(14) << query << std::fixed << std::setprecision(1)
+                      << std::setw(12) << linear << std::setw(12) << binary << std::setw(9) << linear / binary << "x" << std::endl;
+        } };
+        report("event_index",
+               ns_per_query(event_times, [&](uint32_t t) { return linear_event_index(events, t); }),
+               ns_per_query(event_times, [&](uint32_t t) { return solution.event_index(0, t); }));
+        report("edge_at_event",
+               ns_per_query(any_times, [&](uint32_t t) { return linear_edge_at_event(events, t); }),
+               ns_per_query(any_times, [&](uint32_t t) { return solution.edge_at_event(0, t).node_A.first; }));
+        report("position_at",
+               ns_per_query(any_times, [&](uint32_t t) { return static_cast<uint64_t>(linear_position_at(solution, 1, t).pos_x); }),
+               ns_per_query(any_times, [&](uint32_t t) { return static_cast<uint64_t>(position_at(solution, 1, t).pos_x); }));
+    }
+
+    // maior separação entre k posições: todos os pares contra fecho convexo e calipers
+    std::cout << std::endl << std::setw(8) << "vehicles" << std::setw(14) << "query" << std::setw(12) << "pairs ns"
+              << std::setw(12) << "hull ns" << std::setw(10) << "speedup" << std::endl;
+    std::vector<uint32_t> rounds(std::max<size_t>(n_queries / 100, 1));
+    for (uint32_t k : { 8u, 16u, 32u, 64u, 128u, 256u }) {
+        std::vector<std::vector<Coord>> fleets(rounds.size(), std::vector<Coord>(k));
+        for (auto& fleet : fleets) {
+            for (auto& c : fleet) {
+                c = { (next_random(state) % 1000000) / 100.0, (next_random(state) % 1000000) / 100.0 };
+            }
+        }
+        for (uint32_t r { 0 }; r < rounds.size(); r++) {
+            rounds[r] = r;
+        }
+        std::vector<Coord> points;
+        std::vector<Coord> hull;
+        double pairs { ns_per_query(rounds, [&](uint32_t r) { return all_pairs_separation(fleets[r]); }) };
+        double calipers { ns_per_query(rounds, [&](uint32_t r) {
+            points.assign(fleets[r].begin(), fleets[r].end());
+            return max_separation(points, hull);
+        }) };
+        std::cout << std::setw(8) << k << std::setw(14) << "separation" << std::fixed << std::setprecision(1)
+                  << std::setw(12) << pairs << std::setw(12) << calipers << std::setw(9) << pairs / calipers << "x" << std::endl;
+    }
+    return 0;
+}
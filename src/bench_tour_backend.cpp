@@ -0,0 +1,85 @@
+/**
+ * @file bench_tour_backend.cpp
+ * @brief Microbenchmark of a 2-opt loop on the tour backends
+ * @details Runs the same first-improvement 2-opt loop on a 2,000-node
+ * tour with the vector backend, with the two-level list flattened
+ * before every delta (as every reader did before the point reads),
+ * and with the two-level list read in place. Prints nanoseconds per
+ * evaluated move and the final tour length, which must agree. The
+ * gain is largest while many moves are accepted: once most are
+ * rejected the tour stays flat and the vector is read directly.
+ * Usage: bench_tour_backend [moves]
+ */
+
+
+#include "Cht.hpp"
+#include "MTSPBCInstance.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+
+namespace {
+
+// gerador determinístico, para que as execuções sejam comparáveis
+uint32_t next_random(uint64_t& state) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return static_cast<uint32_t>(state >> 33);
+}
+
+
+// laço 2-opt com os mesmos movimentos candidatos em todas as representações
+void two_opt_loop(Cht& tour, const MTSPBCInstance& instance, const size_t n_moves, const bool flatten_per_read) {
+    uint64_t state { 7 };
+    const size_t n { tour.n_nodes() };
+    for (size_t q { 0 }; q < n_moves; q++) {
+        const uint32_t pos_i { 1 + next_random(state) % static_cast<uint32_t>(n - 3) };
+        const uint32_t pos_e { pos_i + 2 + next_random(state) % std::min<uint32_t>(64, static_cast<uint32_t>(n - 1 - pos_i - 1)) };
+        if (flatten_per_read) {
+            (void)tour.events_view();
+        }
+        if (tour.evaluate_2opt(pos_i, pos_e, instance) < 0) {
+            tour.reverse_subtour(instance, pos_i, pos_e);
+        }
+    }
+}
+
+}
+
+
+int main(int argc, char** argv) {
+    const size_t n_moves { (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 20000 };
+    constexpr uint32_t n_nodes { 2000 };
+    uint64_t state { 42 };
+    std::vector<Coord> coordinates(n_nodes);
+    for (auto& c : coordinates) {
+        c = { static_cast<double>(next_random(state) % 10000), static_cast<double>(next_random(state) % 10000) };
+    }
+    MTSPBCInstance instance(std::move(coordinates), 1, 1);             // raio mínimo: o índice de cobertura fica pequeno
+
+    std::cout << std::setw(16) << "backend" << std::setw(14) << "ns per move" << std::setw(12) << "length" << std::endl;
+    auto run { [&](const char* label, const TourBackend backend, const bool flatten_per_read) {
+        Cht tour;
+        tour.set_backend(backend);
+        for (uint32_t node { 0 }; node < n_nodes; node++) {
+            tour.push_back(node, instance);
+        }
+        tour.push_back(0, instance);
+        auto start { std::chrono::steady_clock::now() };
+        two_opt_loop(tour, instance, n_moves, flatten_per_read);
+        auto elapsed { std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() };
+        // o comprimento vem do último evento: reverse_subtour não atualiza o objetivo
+        const uint32_t length { tour.events_view().back() };
+        std::cout << std::setw(16) << label << std::fixed << std::setprecision(1) << std::setw(14) << elapsed / n_moves
+                  << std::setw(12) << length << std::endl;
+    } };
+    run("vector", TourBackend::vector, false);
+    run("list, flattened", TourBackend::two_level, true);
+    run("list", TourBackend::two_level, false);
+    return 0;
+}
@@ -8,6 +8,8 @@
 
 #include "chmtsp_util.hpp"
 #include "MTSPBC_util.hpp"
+#include "MappedFile.hpp"
+#include "TextParser.hpp"
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
@@ -17,6 +19,7 @@
 #include <utility>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <fstream>
 #include <iostream>
 #include <cmath>
@@ -85,35 +88,27 @@ uint32_t read_instance(std::string file_name, std::vector<Coord>& coord, uint32_
  */
 std::vector<std::vector<uint32_t>> read_inst_dist(std::string input_file) {
 
-    // create fstream file object from file name string
-    std::ifstream input_instance(input_file);
+    // map the file, it throws if the file cannot be open
+    MappedFile file(input_file);
+    std::string_view text { reinterpret_cast<const char*>(file.data()), file.size() };
 
-    // checks if the file was open
-    if (!input_instance.is_open()) {
-        throw std::runtime_error("error: cannot open file");
-    }
-
-    bool parameters_read {false};
-    std::string line;
+    // skip comments and the header line
+    text = skip_header_line(text);
 
-    while (std::getline(input_instance, line)) {
-        if (line.empty() || line[0] == '#') {
-            continue;
+    // parse the distance lines on all cores
+    parallel_for_lines(text, [](const size_t, std::string_view line) {
+        LineReader reader(line);
+        if (reader.blank()) {
+            return;
         }
-
-        std::stringstream ss(line);     // stream para ler os valores separados por espaços
-
-        if(!parameters_read) {
-            parameters_read = true;
-        } else {
-            size_t i{};
-            size_t j{};
-            uint32_t dist{};
-            ss >> i >> j >> dist;
-            matriz_dist[i][j] = dist;   // le matriz de distancias
+        size_t i{};
+        size_t j{};
+        uint32_t dist{};
+        if (!reader.read(i) || !reader.read(j) || !reader.read(dist)) {
+            throw std::runtime_error("error: malformed distance line");
         }
-
-    }
+        matriz_dist[i][j] = dist;   // le matriz de distancias
+    });
 
     return matriz_dist;
 }
@@ -127,15 +122,13 @@ std::vector<std::vector<uint32_t>> read_inst_dist(std::string input_file) {
  * @return Returns 0 if the file was read and parameters retrieved.
  */
 uint32_t read_cover(std::string cover_file){
-    // open cover.dat file
+    // checks if the file can be open
     std::ifstream cover_f(cover_file);
-    // checks if the file was open
     if (!cover_f.is_open()) {
         std::cerr << "error loading cover file!" << std::endl;
         return 1;
     }
-    // variable to store the current read line
-    std::string line;
+    cover_f.close();
     // resize lower and upper bound variable
     LB.resize(n_nodes);
     UB.resize(n_nodes);
@@ -147,18 +140,22 @@ uint32_t read_cover(std::string cover_file){
             UB[i][j].resize(n_nodes);
         }
     }
-    // read and process line by line
-    while (std::getline(cover_f, line)) {
-        if (line.empty()) {
-            continue;
+    // read and process the lines on all cores
+    MappedFile file(cover_file);
+    std::string_view text { reinterpret_cast<const char*>(file.data()), file.size() };
+    parallel_for_lines(text, [](const size_t, std::string_view line) {
+        LineReader reader(line);
+        if (reader.blank()) {
+            return;
         }
-        std::stringstream ss(line);
         size_t i{}, j{}, k{};
         double lb_tmp{}, ub_tmp{};
-        ss >> i >> j >> k >> lb_tmp >> ub_tmp;
+        if (!reader.read(i) || !reader.read(j) || !reader.read(k) || !reader.read(lb_tmp) || !reader.read(ub_tmp)) {
+            throw std::runtime_error("error: malformed cover line");
+        }
         LB[i][j][k] = lb_tmp;
         UB[i][j][k] = ub_tmp;
-    }
+    });
     return 0;
 }
 
@@ -1,9 +1,12 @@
 #include "Cht.hpp"
 #include "MTSPBCInstance.hpp"
+#include "TwoLevelList.hpp"
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <gtest/gtest.h>
 #include <memory>
+#include <optional>
 #include <stdexcept>
 #include <vector>
 
@@ -154,3 +157,148 @@ TEST_F(ChmtspTest, GetPosNode) {
     auto index { tour_test.get_pos_for_node(3) };
     EXPECT_EQ(index, 2);
 }
+
+
+// o índice de posições acompanha as edições e concorda com uma busca linear
+TEST_F(ChmtspTest, NodeIndexFollowsEdits) {
+    Cht tour_test;
+    const MTSPBCInstance& cref = *instance;
+    auto check { [&]() {
+        std::vector<uint32_t> tour { tour_test.get_tour() };
+        for (uint32_t node { 0 }; node < 12; node++) {
+            auto it { std::find(tour.begin(), tour.end(), node) };
+            std::optional<size_t> expected { std::nullopt };
+            if (node == 0 && !tour.empty() && tour.back() == 0) {
+                expected = tour.size() - 1;
+            } else if (it != tour.end()) {
+                expected = it - tour.begin();
+            }
+            EXPECT_EQ(tour_test.get_pos_for_node(node), expected);
+        }
+    } };
+    for (uint32_t node { 1 }; node < 9; node++) {
+        tour_test.push_back(node, cref);
+    }
+    check();
+    tour_test.insert_node(9, 3, cref);
+    tour_test.remove_node(6, cref);
+    check();
+    tour_test.reverse_subtour(cref, 1, 6);
+    tour_test.insert_node(4, 2, cref);          // nó repetido: vale a primeira ocorrência
+    check();
+    tour_test.remove_node(1, cref);
+    tour_test.push_front(0, cref);
+    tour_test.push_back(0, cref);
+    check();
+    tour_test.pop_back(cref);
+    tour_test.pop_front(cref);
+    tour_test.reverse_tour(cref);
+    check();
+}
+
+
+// a lista de dois níveis concorda com um vetor sob edições aleatórias
+TEST(TwoLevelListTest, MatchesVector) {
+    std::vector<uint32_t> expected { 0 };
+    for (uint32_t node { 1 }; node < 300; node++) {
+        expected.push_back(node);
+    }
+    TwoLevelList list(expected);
+    uint64_t state { 7 };
+    auto next { [&](const size_t bound) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return static_cast<size_t>((state >> 33) % bound);
+    } };
+    std::vector<uint32_t> flat;
+    for (uint32_t step { 0 }; step < 3000; step++) {
+        size_t kind { next(3) };
+        if (kind == 0) {
+            size_t pos { next(expected.size() + 1) };
+            expected.insert(expected.begin() + pos, step);
+            list.insert(pos, step);
+        } else if (kind == 1 && expected.size() > 1) {
+            size_t pos { next(expected.size()) };
+            expected.erase(expected.begin() + pos);
+            list.erase(pos);
+        } else {
+            size_t pos_i { next(expected.size() + 1) };
+            size_t pos_e { pos_i + next(expected.size() - pos_i + 1) };
+            std::reverse(expected.begin() + pos_i, expected.begin() + pos_e);
+            list.reverse(pos_i, pos_e);
+        }
+        ASSERT_EQ(list.size(), expected.size());
+        size_t probe { next(expected.size()) };
+        ASSERT_EQ(list.at(probe), expected[probe]);
+        size_t first { next(expected.size() + 1) };
+        size_t last { first + next(expected.size() - first + 1) };
+        list.copy_range(first, last, flat);
+        ASSERT_TRUE(std::equal(flat.begin(), flat.end(), expected.begin() + first, expected.begin() + last));
+    }
+    list.flatten(flat);
+    EXPECT_EQ(flat, expected);
+    EXPECT_EQ(list.back(), expected.back());
+    EXPECT_THROW(list.reverse(2, expected.size() + 1), std::out_of_range);
+}
+
+
+// as duas representações da rota dão a mesma rota, eventos e objetivo
+TEST_F(ChmtspTest, TwoLevelBackendMatchesVector) {
+    const MTSPBCInstance& cref = *instance;
+    Cht by_vector;
+    Cht by_list;
+    by_list.set_backend(TourBackend::two_level);
+    for (Cht* tour : { &by_vector, &by_list }) {
+        tour->push_back(0, cref);
+        for (uint32_t node { 1 }; node < 120; node++) {
+            tour->push_back(node, cref);
+        }
+        tour->push_back(0, cref);
+    }
+    uint64_t state { 11 };
+    auto next { [&](const size_t bound) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return static_cast<size_t>((state >> 33) % bound);
+    } };
+    for (uint32_t step { 0 }; step < 400; step++) {
+        size_t n { by_vector.n_nodes() };
+        size_t kind { next(4) };
+        if (kind == 0) {
+            size_t pos { 1 + next(n - 1) };
+            uint32_t node { static_cast<uint32_t>(1 + next(cref.n() - 1)) };
+            EXPECT_EQ(by_list.insert_node(node, pos, cref), by_vector.insert_node(node, pos, cref));
+        } else if (kind == 1 && n > 3) {
+            size_t pos { 1 + next(n - 2) };
+            EXPECT_EQ(by_list.remove_node(pos, cref), by_vector.remove_node(pos, cref));
+        } else if (kind == 2) {
+            uint32_t pos_i { static_cast<uint32_t>(1 + next(n - 2)) };
+            uint32_t pos_e { static_cast<uint32_t>(pos_i + next(n - 1 - pos_i)) };
+            by_list.reverse_subtour(cref, pos_i, pos_e);
+            by_vector.reverse_subtour(cref, pos_i, pos_e);
+        } else {
+            ASSERT_EQ(by_list.n_nodes(), n);
+            EXPECT_EQ(by_list.get_tour(), by_vector.get_tour());
+            EXPECT_EQ(by_list.get_events(), by_vector.get_events());
+        }
+        EXPECT_EQ(by_list.get_obj(), by_vector.get_obj());
+        EXPECT_EQ(by_list.get_complete(), by_vector.get_complete());
+        // leituras pontuais e deltas com edições pendentes na lista
+        size_t m { by_vector.n_nodes() };
+        size_t probe { next(m) };
+        EXPECT_EQ(by_list.get_node_at_pos(probe), by_vector.get_node_at_pos(probe));
+        EXPECT_EQ(by_list.n_events(), by_vector.n_events());
+        EXPECT_EQ(by_list.evaluate_remove(probe, cref), by_vector.evaluate_remove(probe, cref));
+        EXPECT_EQ(by_list.evaluate_insert(7, probe, cref), by_vector.evaluate_insert(7, probe, cref));
+        uint32_t pos_i { static_cast<uint32_t>(next(m)) };
+        uint32_t pos_e { static_cast<uint32_t>(pos_i + 1 + next(m - pos_i)) };
+        EXPECT_EQ(by_list.evaluate_2opt(pos_i, pos_e, cref), by_vector.evaluate_2opt(pos_i, pos_e, cref));
+        uint32_t to_pos { static_cast<uint32_t>(next(m - (pos_e - pos_i) + 1)) };
+        EXPECT_EQ(by_list.evaluate_or_opt(pos_i, pos_e, to_pos, cref), by_vector.evaluate_or_opt(pos_i, pos_e, to_pos, cref));
+    }
+    by_list.reverse_tour(cref);
+    by_vector.reverse_tour(cref);
+    by_list.pop_back(cref);
+    by_vector.pop_back(cref);
+    EXPECT_EQ(by_list.get_tour(), by_vector.get_tour());
+    EXPECT_EQ(by_list.get_events(), by_vector.get_events());
+    EXPECT_EQ(by_list.get_pos_for_node(5), by_vector.get_pos_for_node(5));
+}
@@ -0,0 +1,140 @@
+#include "CoverBuilder.hpp"
+#include "CostMatrix.hpp"
+#include "CoverIndex.hpp"
+#include "MTSPBC_ds.hpp"
+#include "SpatialGrid.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <vector>
+
+
+// testa consulta de janelas de cobertura
+TEST(CoverIndexTest, LookupWindows) {
+    std::vector<CoverTriple> triples {
+        { 2, 0, 1, 3.5, 7.0 },
+        { 1, 0, 1, 0.0, 2.0 },
+        { 3, 0, 1, 9.0, 1.0 },      // não cobre, descartado
+        { 0, 2, 3, 1.0, 1.5 },
+    };
+    CoverIndex cover(4, std::move(triples));
+
+    EXPECT_EQ(cover.n_windows(), 3);
+    EXPECT_NEAR(cover.get_LB(2, 0, 1), 3.5, 1e-9);
+    EXPECT_NEAR(cover.get_UB(2, 0, 1), 7.0, 1e-9);
+    EXPECT_TRUE(cover.covers(0, 2, 3));
+    EXPECT_FALSE(cover.covers(3, 0, 1));
+    EXPECT_LT(cover.get_UB(3, 0, 1), cover.get_LB(3, 0, 1));
+    EXPECT_TRUE(std::isinf(cover.get_LB(0, 1, 0)));
+}
+
+
+// testa lista de nós cobertos por uma aresta
+TEST(CoverIndexTest, CoveredByEdge) {
+    std::vector<CoverTriple> triples {
+        { 3, 1, 2, 0.0, 1.0 },
+        { 0, 1, 2, 0.5, 1.0 },
+        { 2, 1, 2, 0.0, 4.0 },
+    };
+    CoverIndex cover(4, std::move(triples));
+
+    auto windows { cover.covered_by(1, 2) };
+    ASSERT_EQ(windows.size(), 3);
+    EXPECT_EQ(windows[0].covered_node, 0);
+    EXPECT_EQ(windows[1].covered_node, 2);
+    EXPECT_EQ(windows[2].covered_node, 3);
+    EXPECT_TRUE(cover.covered_by(2, 1).empty());
+    EXPECT_THROW((void)cover.covered_by(4, 0), std::out_of_range);
+}
+
+
+// blocos mapeados com offsets fora de ordem ou além das janelas são rejeitados
+TEST(CoverIndexTest, ViewRejectsBadOffsets) {
+    std::vector<CoverWindow> windows(3);
+    std::vector<uint32_t> offsets { 0, 1, 2, 2, 3 };
+    CoverIndex cover { CoverIndex::view(2, offsets, windows, nullptr) };
+    EXPECT_EQ(cover.covered_by(1, 0).size(), 0u);
+    EXPECT_EQ(cover.covered_by(1, 1).size(), 1u);
+    for (const std::vector<uint32_t>& bad : { std::vector<uint32_t> { 0, 3, 1, 3, 3 }, std::vector<uint32_t> { 0, 9, 9, 9, 3 },
+                                              std::vector<uint32_t> { 1, 1, 2, 2, 3 }, std::vector<uint32_t> { 0, 1, 2, 3 } }) {
+        EXPECT_THROW((void)CoverIndex::view(2, bad, windows, nullptr), std::runtime_error);
+    }
+}
+
+
+// testa a interseção segmento-círculo e a cobertura calculada a partir das coordenadas
+TEST(CoverIndexTest, BuildCoverFromCoordinates) {
+    std::vector<double> xs { 5.0, 5.0, 0.0, 30.0, 1.0, 2.0, 3.0, 4.0, 9.0 };
+    std::vector<double> ys { 0.0, 3.0, 0.0, 0.0, 5.0, 6.0, 7.0, 8.0, 0.0 };
+    std::vector<double> lo(xs.size());
+    std::vector<double> hi(xs.size());
+    segment_circle_windows(xs.data(), ys.data(), xs.size(), { 0.0, 0.0 }, { 10.0, 0.0 }, 5.0, lo.data(), hi.data());
+    EXPECT_NEAR(lo[0], 0.0, 1e-9);
+    EXPECT_NEAR(hi[0], 1.0, 1e-9);
+    EXPECT_NEAR(lo[1], 0.1, 1e-9);
+    EXPECT_NEAR(hi[1], 0.9, 1e-9);
+    EXPECT_NEAR(hi[2], 0.5, 1e-9);
+    EXPECT_LT(hi[3], lo[3]);
+    EXPECT_NEAR(lo[8], 0.4, 1e-9);
+    EXPECT_NEAR(hi[8], 1.0, 1e-9);
+
+    std::vector<Coord> coordinates { { 0.0, 0.0 }, { 10.0, 0.0 }, { 5.0, 3.0 }, { 50.0, 50.0 } };
+    CostMatrix cost(4);
+    for (uint32_t i { 0 }; i < 4; i++) {
+        for (uint32_t j { 0 }; j < 4; j++) {
+            cost.set(i, j, std::round(std::hypot(coordinates[i].pos_x - coordinates[j].pos_x, coordinates[i].pos_y - coordinates[j].pos_y)));
+        }
+    }
+    CoverIndex cover { build_cover(coordinates, cost, 5) };
+    EXPECT_TRUE(cover.covers(2, 0, 1));
+    EXPECT_NEAR(cover.get_LB(2, 0, 1), 1.0, 1e-9);
+    EXPECT_NEAR(cover.get_UB(2, 0, 1), 9.0, 1e-9);
+    EXPECT_TRUE(cover.covers(0, 0, 1));
+    EXPECT_FALSE(cover.covers(3, 0, 1));
+    EXPECT_TRUE(cover.covered_by(0, 0).empty());
+}
+
+
+// consulta por segmento igual à força bruta, percorrendo só o corredor de células do segmento
+TEST(SpatialGridTest, SegmentCorridor) {
+    uint64_t state { 11 };
+    auto next { [&]() { state = state * 6364136223846793005ULL + 1442695040888963407ULL; return static_cast<uint32_t>(state >> 33); } };
+    std::vector<Coord> coordinates(10000);
+    for (auto& c : coordinates) {
+        c = { (next() % 1000000) / 100.0, (next() % 1000000) / 100.0 };
+    }
+    for (double radius : { 0.5, 10.0, 300.0 }) {
+        SpatialGrid grid(coordinates, radius);
+        for (uint32_t q { 0 }; q < 60; q++) {
+            Coord a { coordinates[next() % coordinates.size()] };
+            Coord b { coordinates[next() % coordinates.size()] };
+            if (q % 3 == 1) {
+                b.pos_y = a.pos_y;              // horizontal
+            } else if (q % 6 == 2) {
+                b = a;                          // degenerado
+            }
+            std::vector<uint32_t> near {};
+            grid.near_segment(a, b, radius, near);
+            std::vector<uint32_t> expected {};
+            Coord ab { b - a };
+            double ab_2 { ab.pos_x * ab.pos_x + ab.pos_y * ab.pos_y };
+            for (uint32_t i { 0 }; i < coordinates.size(); i++) {
+                Coord ap { coordinates[i] - a };
+                double t { (ab_2 > 0) ? std::clamp((ap.pos_x * ab.pos_x + ap.pos_y * ab.pos_y) / ab_2, 0.0, 1.0) : 0.0 };
+                Coord d { ap - ab * t };
+                if (d.pos_x * d.pos_x + d.pos_y * d.pos_y <= radius * radius) {
+                    expected.push_back(i);
+                }
+            }
+            ASSERT_EQ(near, expected);
+        }
+    }
+    // diagonal do mapa: o corredor tem O(linhas) células, não a grade inteira
+    SpatialGrid grid(coordinates, 10.0);
+    std::vector<uint32_t> candidates {};
+    uint32_t visited { grid.segment_candidates({ 0.0, 0.0 }, { 10000.0, 10000.0 }, 10.0, candidates) };
+    EXPECT_LT(visited, grid.n_cells() / 20);
+}
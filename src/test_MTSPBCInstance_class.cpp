@@ -1,8 +1,18 @@
+#include "DistanceBuilder.hpp"
 #include "MTSPBCInstance.hpp"
+#include "MTSPBC_util.hpp"
+#include "TextParser.hpp"
+#include "chmtsp_util.hpp"
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
 #include <gtest/gtest.h>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
 
 
 class MTSPBCInstanceTest : public ::testing::Test {
@@ -38,3 +48,259 @@ TEST_F(MTSPBCInstanceTest, GotLBUB) {
     EXPECT_NEAR(instance->get_LB(198, 197, 198), 39.79591836734694, 1e-3);
     EXPECT_NEAR(instance->get_UB(198, 197, 198), 50, 1e-3);
 }
+
+TEST_F(MTSPBCInstanceTest, BinaryCacheRoundTrip) {
+    std::string filepath { "../experiments/BC/R1_5v_200n.bc" };
+    std::string dist_filepath { "../experiments/inst.dat" };
+    std::string cover_filepath { "../experiments/cover.dat" };
+    std::string cache_filepath { "../data/R1_5v_200n.cache" };
+    std::remove(cache_filepath.c_str());
+    MTSPBCInstance compiled(filepath, dist_filepath, cover_filepath, cache_filepath);
+    MTSPBCInstance mapped(cache_filepath);
+    ASSERT_EQ(mapped.n(), instance->n());
+    EXPECT_EQ(mapped.k(), instance->k());
+    EXPECT_EQ(mapped.r(), instance->r());
+    for (uint32_t i { 0 }; i < mapped.n(); i++) {
+        EXPECT_EQ(mapped.coordinate(i).pos_x, instance->coordinate(i).pos_x);
+        for (uint32_t j { 0 }; j < mapped.n(); j++) {
+            ASSERT_EQ(mapped.cost(i, j), instance->cost(i, j));
+            ASSERT_EQ(mapped.covered_by(i, j).size(), instance->covered_by(i, j).size());
+        }
+    }
+    uint32_t last { mapped.n() - 1 };
+    EXPECT_EQ(mapped.get_LB(last, last - 1, last), instance->get_LB(last, last - 1, last));
+    EXPECT_EQ(mapped.get_UB(last, last - 1, last), instance->get_UB(last, last - 1, last));
+}
+
+
+// testa se a divisão em blocos entrega cada linha exatamente uma vez
+TEST(TextParserTest, ParallelLinesSplit) {
+    std::string text {};
+    for (uint32_t i { 0 }; i < 1000; i++) {
+        text += std::to_string(i) + " " + std::to_string(2 * i) + " 0.5\n";
+    }
+    std::vector<std::vector<uint32_t>> seen(7);
+    size_t n_chunks { parallel_for_lines(text, [&](const size_t chunk, std::string_view line) {
+        LineReader reader(line);
+        uint32_t a {};
+        uint32_t b {};
+        double c {};
+        ASSERT_TRUE(reader.read(a) && reader.read(b) && reader.read(c));
+        EXPECT_EQ(b, 2 * a);
+        seen[chunk].push_back(a);
+    }, 7) };
+    std::vector<uint32_t> all {};
+    for (size_t c { 0 }; c < n_chunks; c++) {
+        all.insert(all.end(), seen[c].begin(), seen[c].end());
+    }
+    ASSERT_EQ(all.size(), 1000);
+    for (uint32_t i { 0 }; i < 1000; i++) {
+        EXPECT_EQ(all[i], i);
+    }
+}
+
+
+// testa se a matriz calculada a partir das coordenadas é idêntica a distance()
+TEST_F(MTSPBCInstanceTest, DistancesFromCoordinates) {
+    MTSPBCInstance computed("../experiments/BC/R1_5v_200n.bc");
+    ASSERT_EQ(computed.n(), instance->n());
+    for (uint32_t i { 0 }; i < computed.n(); i++) {
+        for (uint32_t j { 0 }; j < computed.n(); j++) {
+            ASSERT_EQ(computed.cost(i, j), distance(computed.coordinate(i), computed.coordinate(j)));
+        }
+    }
+}
+
+
+// testa a instância montada em memória a partir das coordenadas, com custo e cobertura calculados
+TEST(MTSPBCInstanceBuildTest, FromCoordinates) {
+    std::vector<Coord> coords { { 0, 0 }, { 10, 0 }, { 10, 10 }, { 0, 10 }, { 5, 5 } };
+    MTSPBCInstance built(std::move(coords), 2, 3);
+    EXPECT_EQ(built.n(), 5);
+    EXPECT_EQ(built.k(), 2);
+    EXPECT_EQ(built.r(), 3);
+    EXPECT_EQ(built.cost(0, 1), 10);
+    EXPECT_EQ(built.cost(0, 2), 14);
+    EXPECT_TRUE(built.covers(4, 0, 2));          // (5, 5) está sobre a diagonal
+    EXPECT_FALSE(built.covers(4, 0, 1));
+}
+
+
+TEST_F(MTSPBCInstanceTest, FromMovedMatrices) {
+    std::vector<Coord> coords {};
+    for (uint32_t i { 0 }; i < instance->n(); i++) {
+        coords.push_back(instance->coordinate(i));
+    }
+    CostMatrix cost_matrix(instance->n());
+    for (uint32_t i { 0 }; i < instance->n(); i++) {
+        for (uint32_t j { 0 }; j < instance->n(); j++) {
+            cost_matrix.set(i, j, instance->cost(i, j) + 1);
+        }
+    }
+    MTSPBCInstance built(std::move(coords), instance->k(), instance->r(), std::move(cost_matrix));
+    EXPECT_EQ(built.cost(1, 2), instance->cost(1, 2) + 1);
+    EXPECT_EQ(built.n(), instance->n());
+    EXPECT_THROW(MTSPBCInstance(std::vector<Coord>(3), 1, 1, CostMatrix(4)), std::logic_error);
+}
+
+
+TEST_F(MTSPBCInstanceTest, NeighbourLists) {
+    ASSERT_EQ(instance->n_neighbours(), std::min(MTSPBCInstance::default_neighbours, instance->n() - 1));
+    for (uint32_t i { 0 }; i < instance->n(); i++) {
+        auto list { instance->neighbours(i) };
+        ASSERT_EQ(list.size(), instance->n_neighbours());
+        uint32_t farthest { 0 };
+        for (size_t p { 0 }; p < list.size(); p++) {
+            ASSERT_NE(list[p], i);
+            ASSERT_GE(instance->cost(i, list[p]), farthest);
+            farthest = instance->cost(i, list[p]);
+        }
+        // nenhum nó fora da lista é mais próximo que o último da lista
+        for (uint32_t j { 0 }; j < instance->n(); j++) {
+            if (j != i && !instance->is_neighbour(i, j)) {
+                ASSERT_GE(instance->cost(i, j), farthest);
+            }
+        }
+    }
+}
+
+
+TEST_F(MTSPBCInstanceTest, SpatialQueries) {
+    const double radius { static_cast<double>(instance->r()) };
+    auto dist_2 { [](const Coord& a, const Coord& b) {
+        Coord d { a - b };
+        return d.pos_x * d.pos_x + d.pos_y * d.pos_y;
+    } };
+    std::vector<uint32_t> got {};
+    for (uint32_t i { 0 }; i < instance->n(); i += 7) {
+        Coord p { instance->coordinate(i) + Coord { 0.5, -0.25 } };
+
+        got.clear();
+        instance->nodes_within(p, got);
+        std::vector<uint32_t> expected {};
+        for (uint32_t j { 0 }; j < instance->n(); j++) {
+            if (dist_2(instance->coordinate(j), p) <= radius * radius) {
+                expected.push_back(j);
+            }
+        }
+        ASSERT_EQ(got, expected);
+
+        got.clear();
+        instance->nearest_nodes(p, 5, got);
+        std::vector<uint32_t> order(instance->n());
+        for (uint32_t j { 0 }; j < instance->n(); j++) {
+            order[j] = j;
+        }
+        std::sort(order.begin(), order.end(), [&](const uint32_t a, const uint32_t b) {
+            double da { dist_2(instance->coordinate(a), p) };
+            double db { dist_2(instance->coordinate(b), p) };
+            return (da != db) ? da < db : a < b;
+        });
+        order.resize(std::min<size_t>(5, order.size()));
+        ASSERT_EQ(got, order);
+
+        uint32_t j { (i * 31 + 11) % instance->n() };
+        if (j == i) {
+            continue;
+        }
+        got.clear();
+        instance->nodes_near_edge(i, j, got);
+        for (uint32_t c { 0 }; c < instance->n(); c++) {
+            bool near { std::binary_search(got.begin(), got.end(), c) };
+            if (instance->covers(c, i, j)) {
+                ASSERT_TRUE(near);
+            }
+        }
+    }
+}
+
+
+TEST(CostMatrixTest, CompressedLayouts) {
+    const uint32_t n { 37 };
+    auto fill { [n](const bool symmetric, const uint32_t scale) {
+        CostMatrix m(n);
+        for (uint32_t i { 0 }; i < n; i++) {
+            for (uint32_t j { 0 }; j < n; j++) {
+                uint32_t lo { std::min(i, j) };
+                uint32_t hi { std::max(i, j) };
+                m.set(i, j, (lo * 131 + hi * 7 + ((symmetric || i < j) ? 0 : 1)) * scale);
+            }
+        }
+        return m;
+    } };
+    struct Case { bool symmetric; uint32_t scale; CostLayout layout; uint32_t entry_bytes; };
+    for (const Case& c : { Case { true, 1, CostLayout::triangle, 2 }, Case { true, 100000, CostLayout::triangle, 4 },
+                           Case { false, 1, CostLayout::full, 2 }, Case { false, 100000, CostLayout::full, 4 } }) {
+        CostMatrix full { fill(c.symmetric, c.scale) };
+        CostMatrix packed { CostMatrix::compress(fill(c.symmetric, c.scale)) };
+        EXPECT_EQ(packed.layout(), c.layout);
+        EXPECT_EQ(packed.entry_bytes(), c.entry_bytes);
+        EXPECT_LE(packed.size_bytes(), full.size_bytes());
+        for (uint32_t i { 0 }; i < n; i++) {
+            for (uint32_t j { 0 }; j < n; j++) {
+                ASSERT_EQ(packed.get(i, j), full.get(i, j));
+            }
+        }
+        CostMatrix copy { packed };
+        EXPECT_EQ(copy.get(n - 1, 3), full.get(n - 1, 3));
+        if (c.layout != CostLayout::full || c.entry_bytes != 4) {
+            EXPECT_THROW(copy.set(0, 1, 5), std::logic_error);
+        }
+    }
+}
+
+
+// testa o arredondamento do kernel vetorial nos casos de meio inteiro
+TEST(DistanceBuilderTest, RoundsHalfAwayFromZero) {
+    std::vector<double> xs { 0.5, 2.5, 3.0, 1.5, 0.0, 7.0, 0.49999999999999994, 1e6 + 0.5 };
+    std::vector<double> ys { 0.0, 0.0, 4.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    std::vector<uint32_t> out(xs.size());
+    distance_row(xs.data(), ys.data(), xs.size(), { 0.0, 0.0 }, out.data());
+    for (size_t j { 0 }; j < xs.size(); j++) {
+        EXPECT_EQ(out[j], distance(Coord { 0.0, 0.0 }, Coord { xs[j], ys[j] }));
+    }
+    EXPECT_EQ(out[0], 1);
+    EXPECT_EQ(out[1], 3);
+    EXPECT_EQ(out[2], 5);
+}
+
+
+// leitores antigos de chmtsp_util sobre arquivos pequenos gerados aqui
+TEST(ChmtspUtilTest, ReadsDistanceAndCover) {
+    std::string inst_filepath { "chmtsp_util_test.bc" };
+    std::string dist_filepath { "chmtsp_util_test_inst.dat" };
+    std::string cover_filepath { "chmtsp_util_test_cover.dat" };
+    {
+        std::ofstream inst(inst_filepath);
+        inst << "# k n r\n1 2 5\n0 0\n3 4\n6 8\n";
+        std::ofstream dist(dist_filepath);
+        dist << "3\n";
+        for (uint32_t i { 0 }; i < 3; i++) {
+            for (uint32_t j { 0 }; j < 3; j++) {
+                dist << i << " " << j << " " << 5 * (std::max(i, j) - std::min(i, j)) << "\n";
+            }
+        }
+        std::ofstream cover(cover_filepath);
+        cover << "0 2 1 0.0 10.0\n2 0 1 7.5 2.5\n";
+    }
+    std::vector<Coord> coord;
+    uint32_t k {};
+    uint32_t n {};
+    uint32_t r {};
+    EXPECT_EQ(read_instance(inst_filepath, coord, k, n, r), 3);
+    EXPECT_EQ(k, 1);
+    EXPECT_EQ(n, 2);
+    EXPECT_EQ(r, 5);
+    ASSERT_EQ(coord.size(), 3);
+    EXPECT_EQ(coord[2].pos_y, 8.0);
+    std::vector<std::vector<uint32_t>> dist { read_inst_dist(dist_filepath) };
+    ASSERT_EQ(dist.size(), 3);
+    EXPECT_EQ(dist[0][2], 10);
+    EXPECT_EQ(dist[2][1], 5);
+    EXPECT_EQ(read_cover(cover_filepath), 0);
+    EXPECT_TRUE(covers_node(0, 2, 1));
+    EXPECT_FALSE(covers_node(2, 0, 1));
+    std::remove(inst_filepath.c_str());
+    std::remove(dist_filepath.c_str());
+    std::remove(cover_filepath.c_str());
+}
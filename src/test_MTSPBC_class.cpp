@@ -1,11 +1,21 @@
+#include "Cht.hpp"
 #include "MTSPBC.hpp"
 #include "MTSPBC_chh.hpp"
 #include "MTSPBC_util.hpp"
+#include "SegmentTree.hpp"
+#include "Trajectories.hpp"
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <fstream>
 #include <gtest/gtest.h>
 #include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
 #include <vector>
 
 
@@ -26,6 +36,24 @@ class MTSPBCTest : public ::testing::Test {
         un_nodes.clear();
     }
 
+    // solução da heurística construtiva; closed também atribui a garagem e fecha as rotas
+    static MTSPBC build_heuristic(const MTSPBCInstance& cref, const bool closed) {
+        MTSPBC solution(cref);
+        for (uint32_t i { 0 }; i < cref.n(); i++) {
+            un_nodes.push_back(i);
+        }
+        for (uint32_t i { 0 }; i < cref.k(); i++) {
+            solution.create_vehicle();
+        }
+        find_onion_hull(solution, un_nodes, cref);
+        cheapest_insertion(solution, un_nodes, cref, false);
+        if (closed) {
+            assign_garage(solution, un_nodes);
+            close_tours(solution);
+        }
+        return solution;
+    }
+
     static void TearDownTestSuite() {
         instance.reset();
     }
@@ -155,6 +183,742 @@ TEST_F(MTSPBCTest, AssignDepot) {
 }
 
 
+TEST_F(MTSPBCTest, GranularInsertion) {
+    const MTSPBCInstance& cref = *instance;
+    MTSPBC solution(cref);
+    for (uint32_t i { 0 }; i < cref.n(); i++) {
+        un_nodes.push_back(i);
+    }
+    for (uint32_t i { 0 }; i < cref.k(); i++) {
+        solution.create_vehicle();
+    }
+    solution.set_radius(cref.r());
+    find_onion_hull(solution, un_nodes, cref);
+    ASSERT_NO_THROW(cheapest_insertion(solution, un_nodes, cref, false, true));
+    assign_garage(solution, un_nodes, true);
+    ASSERT_TRUE(un_nodes.size() == 0);
+    uint32_t assigned { 0 };
+    for (uint32_t i { 0 }; i < solution.get_k_vehicles(); i++) {
+        ASSERT_TRUE(solution.get_pos_for_node(i, 0));
+        assigned += solution.n_nodes(i);
+    }
+    ASSERT_GE(assigned, cref.n());
+}
+
+
+TEST_F(MTSPBCTest, IncrementalTimeline) {
+    const MTSPBCInstance& cref = *instance;
+    MTSPBC solution(cref);
+    for (uint32_t i { 0 }; i < cref.k(); i++) {
+        solution.create_vehicle();
+    }
+    auto full_timeline { [&]() {
+        std::vector<std::pair<uint32_t, uint32_t>> events {};
+        for (uint32_t k { 0 }; k < solution.get_k_vehicles(); k++) {
+            for (uint32_t e_time : solution.get_vehicle_events(k)) {
+                events.emplace_back(e_time, k);
+            }
+        }
+        std::sort(events.begin(), events.end());
+        return events;
+    } };
+    for (uint32_t node { 1 }; node < std::min<uint32_t>(cref.n(), 40); node++) {
+        uint32_t k { node % solution.get_k_vehicles() };
+        if (solution.n_nodes(k) < 2) {
+            solution.push_back(k, node);
+        } else {
+            solution.insert_node(k, node, node % solution.n_nodes(k));
+        }
+        ASSERT_EQ(solution.get_events(), full_timeline());
+    }
+    solution.remove_node(1, 1);
+    ASSERT_EQ(solution.get_events(), full_timeline());
+    solution.reverse_tour(0);
+    ASSERT_EQ(solution.get_events(), full_timeline());
+    solution.pop_front(2);
+    ASSERT_EQ(solution.get_events(), full_timeline());
+}
+
+
+TEST_F(MTSPBCTest, SweepMatchesPairwiseDistance) {
+    const MTSPBCInstance& cref = *instance;
+    MTSPBC solution { build_heuristic(cref, true) };
+    solution.set_radius(cref.r());
+    for (uint32_t e { 0 }; e < solution.get_n_events(); e++) {
+        uint32_t expected { 0 };
+        for (uint32_t k { 0 }; k + 1 < solution.get_k_vehicles(); k++) {
+            for (uint32_t l { k + 1 }; l < solution.get_k_vehicles(); l++) {
+                if (solution.n_nodes(k) >= 2 && solution.n_nodes(l) >= 2) {
+                    expected = std::max(expected, distance(solution, e, k, l));
+                }
+            }
+        }
+        ASSERT_EQ(solution.dist_at_event(e), expected);
+    }
+}
+
+
+// o cache por par, refeito só nos pares do veículo alterado, concorda com a varredura completa
+TEST_F(MTSPBCTest, PairCacheMatchesSweep) {
+    const MTSPBCInstance& cref = *instance;
+    MTSPBC solution { build_heuristic(cref, true) };
+    auto check { [&]() {
+        std::vector<uint32_t> distances { solution.get_distances() };
+        uint32_t sweep_max { distances.empty() ? 0 : *std::max_element(distances.begin(), distances.end()) };
+        EXPECT_EQ(solution.get_max_distance(), sweep_max);
+        for (uint32_t k { 0 }; k + 1 < solution.get_k_vehicles(); k++) {
+            for (uint32_t l { k + 1 }; l < solution.get_k_vehicles(); l++) {
+                uint32_t expected { 0 };
+                if (solution.n_nodes(k) >= 2 && solution.n_nodes(l) >= 2) {
+                    for (uint32_t e { 0 }; e < solution.get_n_events(); e++) {
+                        expected = std::max(expected, distance(solution, e, k, l));
+                    }
+                }
+                PairSeparation pair { solution.pair_separation(l, k) };
+                EXPECT_EQ(pair.value, expected);
+                if (expected > 0) {
+                    auto [e_time, e_vehicle] = solution.get_event(solution.get_n_events() - 1);
+                    EXPECT_LE(pair.e_time, e_time);
+                }
+            }
+        }
+    } };
+    check();
+    uint32_t node { solution.get_node_at_pos(0, 2) };
+    solution.remove_node(0, 2);
+    (void)solution.get_max_distance();          // só os pares do veículo 0 são refeitos
+    solution.insert_node(1, node, 2);
+    check();
+    solution.begin();
+    solution.reverse_subtour(1, 1, 4);
+    (void)solution.get_max_distance();
+    solution.remove_node(2, 2);                 // segunda sincronização na mesma transação
+    (void)solution.get_max_distance();
+    solution.rollback();
+    check();
+    solution.reverse_subtour(3, 1, 3);          // só os pares do veículo 3 são refeitos sobre os restaurados
+    check();
+    uint32_t moved { solution.get_node_at_pos(2, 2) };
+    solution.remove_node(2, 2);
+    (void)solution.get_distances();             // só a linha do tempo: os pares ficam pendentes
+    solution.begin();
+    solution.insert_node(2, moved, 2);
+    (void)solution.get_max_distance();          // refaz os pendentes de antes do begin() dentro da transação
+    solution.rollback();
+    check();
+    solution.begin();
+    solution.reverse_subtour(0, 1, 3);
+    (void)solution.get_distance_sum();          // transação sem leitura dos pares
+    solution.rollback();
+    check();
+    EXPECT_THROW((void)solution.pair_separation(0, 0), std::logic_error);
+}
+
+
+// fecho convexo e calipers dão a mesma maior distância que todos os pares
+TEST_F(MTSPBCTest, MaxSeparationMatchesPairs) {
+    uint64_t state { 3 };
+    auto next { [&]() {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return static_cast<uint32_t>(state >> 33);
+    } };
+    std::vector<Coord> points;
+    std::vector<Coord> hull;
+    for (uint32_t round { 0 }; round < 200; round++) {
+        std::vector<Coord> fleet(2 + next() % 60);
+        for (auto& c : fleet) {
+            c = { (next() % 100000) / 100.0, (next() % 100000) / 100.0 };
+        }
+        if (round % 10 == 0) {
+            for (auto& c : fleet) {
+                c.pos_y = 2 * c.pos_x;          // todos colineares
+            }
+        } else if (round % 10 == 1) {
+            for (auto& c : fleet) {             // quase colineares
+                c.pos_y = 2 * c.pos_x + (next() % 100) / 1000.0;
+            }
+        } else if (round % 10 == 2) {
+            for (auto& c : fleet) {             // agrupados em torno de um ponto
+                c = { 500.0 + (next() % 300) / 100.0, 500.0 + (next() % 300) / 100.0 };
+            }
+        } else if (round % 10 == 3) {
+            for (auto& c : fleet) {             // espaçamento menor que uma unidade
+                c = { (next() % 1000) / 1000.0, (next() % 1000) / 1000.0 };
+            }
+        }
+        uint32_t expected { 0 };
+        for (size_t k { 0 }; k + 1 < fleet.size(); k++) {
+            for (size_t l { k + 1 }; l < fleet.size(); l++) {
+                expected = std::max(expected, distance(fleet[k], fleet[l]));
+            }
+        }
+        points = fleet;
+        ASSERT_EQ(max_separation(points, hull), expected);
+    }
+    points.assign(3, Coord { 1.0, 1.0 });
+    EXPECT_EQ(max_separation(points, hull), 0u);
+}
+
+
+// frota grande: a varredura usa max_separation e concorda com os pares
+TEST_F(MTSPBCTest, SweepLargeFleet) {
+    const MTSPBCInstance& cref = *instance;
+    MTSPBC solution(cref);
+    const uint32_t k_vehicles { 30 };
+    for (uint32_t k { 0 }; k < k_vehicles; k++) {
+        solution.create_vehicle();
+        solution.push_back(k, 0);
+        for (uint32_t i { 0 }; i < 3; i++) {
+            solution.push_back(k, 1 + (k * 7 + i * 13) % (cref.n() - 1));
+        }
+        solution.push_back(k, 0);
+    }
+    for (uint32_t e { 0 }; e < solution.get_n_events(); e++) {
+        uint32_t expected { 0 };
+        for (uint32_t k { 0 }; k + 1 < k_vehicles; k++) {
+            for (uint32_t l { k + 1 }; l < k_vehicles; l++) {
+                expected = std::max(expected, distance(solution, e, k, l));
+            }
+        }
+        ASSERT_EQ(solution.dist_at_event(e), expected);
+    }
+    std::vector<uint32_t> distances { solution.get_distances() };
+    EXPECT_EQ(solution.get_max_distance(), *std::max_element(distances.begin(), distances.end()));
+}
+
+
+// interpolação em blocos dá as mesmas posições, bit a bit, que position_at
+TEST_F(MTSPBCTest, TrajectoriesMatchPositionAt) {
+    const MTSPBCInstance& cref = *instance;
+    MTSPBC solution { build_heuristic(cref, true) };
+    const uint32_t n_k { solution.get_k_vehicles() };
+    std::vector<std::span<const uint32_t>> tours(n_k);
+    std::vector<std::span<const uint32_t>> events(n_k);
+    uint32_t last_time { 0 };
+    for (uint32_t k { 0 }; k < n_k; k++) {
+        tours[k] = solution.tour_view(k);
+        events[k] = solution.events_view(k);
+        last_time = std::max(last_time, events[k].back());
+    }
+    Trajectories trajectories;
+    trajectories.assign(tours, events, cref);
+    std::vector<uint32_t> times;
+    for (uint32_t t { 0 }; t <= last_time + 5; t += 3) {
+        times.push_back(t);
+    }
+    std::vector<uint32_t> cursor(n_k, 0);
+    std::vector<double> xs(times.size() * n_k);
+    std::vector<double> ys(times.size() * n_k);
+    // em dois blocos, com o cursor continuando do primeiro
+    size_t half { times.size() / 2 };
+    trajectories.interpolate(std::span<const uint32_t>(times).first(half), cursor, xs.data(), ys.data());
+    trajectories.interpolate(std::span<const uint32_t>(times).subspan(half), cursor, xs.data() + half * n_k, ys.data() + half * n_k);
+    for (size_t q { 0 }; q < times.size(); q++) {
+        for (uint32_t k { 0 }; k < n_k; k++) {
+            Coord expected { position_at(solution, k, times[q]) };
+            ASSERT_EQ(xs[q * n_k + k], expected.pos_x);
+            ASSERT_EQ(ys[q * n_k + k], expected.pos_y);
+        }
+    }
+    solution.save_trajectories("../data/trajectories.dat", 10);
+    std::ifstream trajectories_file("../data/trajectories.dat");
+    ASSERT_TRUE(trajectories_file.is_open());
+    size_t n_lines { 0 };
+    for (std::string line; std::getline(trajectories_file, line);) {
+        n_lines++;
+    }
+    EXPECT_EQ(n_lines, last_time / 10 + 1);
+    EXPECT_THROW(solution.save_trajectories("../data/trajectories.dat", 0), std::logic_error);
+}
+
+
+// máximo em tempo contínuo: limita por cima a amostragem nos eventos e em todo instante inteiro
+TEST_F(MTSPBCTest, ContinuousMaxDistance) {
+    const MTSPBCInstance& cref = *instance;
+    MTSPBC solution { build_heuristic(cref, true) };
+    ContinuousSeparation exact { solution.continuous_max_distance() };
+    EXPECT_GE(std::round(exact.value), solution.get_max_distance());
+    EXPECT_LT(exact.vehicle_1, exact.vehicle_2);
+    uint32_t last_time { 0 };
+    for (uint32_t k { 0 }; k < solution.get_k_vehicles(); k++) {
+        last_time = std::max(last_time, solution.events_view(k).back());
+    }
+    // os veículos andam com velocidade 1: entre instantes inteiros a separação varia no máximo 2
+    double sampled { 0 };
+    for (uint32_t t { 0 }; t <= last_time; t++) {
+        for (uint32_t k { 0 }; k + 1 < solution.get_k_vehicles(); k++) {
+            for (uint32_t l { k + 1 }; l < solution.get_k_vehicles(); l++) {
+                Coord d { position_at(solution, k, t) - position_at(solution, l, t) };
+                sampled = std::max(sampled, std::sqrt(d.pos_x * d.pos_x + d.pos_y * d.pos_y));
+            }
+        }
+    }
+    EXPECT_GE(exact.value + 1e-9, sampled);
+    EXPECT_LE(exact.value, sampled + 3);
+}
+
+
+TEST(SegmentTreeTest, MatchesVector) {
+    std::vector<uint32_t> expected;
+    for (uint32_t i { 0 }; i < 37; i++) {
+        expected.push_back((i * 7919) % 101);
+    }
+    SegmentTree tree;
+    tree.assign(expected);
+    uint64_t state { 7 };
+    auto next { [&]() { state = state * 6364136223846793005ULL + 1442695040888963407ULL; return static_cast<uint32_t>(state >> 33); } };
+    for (uint32_t round { 0 }; round < 300; round++) {
+        if (round % 3 == 0) {
+            // troca o sufixo por outro de tamanho diferente, às vezes além da capacidade
+            size_t first { next() % (expected.size() + 1) };
+            std::vector<uint32_t> values(next() % 40);
+            for (auto& v : values) {
+                v = next() % 1000;
+            }
+            expected.resize(first);
+            expected.insert(expected.end(), values.begin(), values.end());
+            tree.assign_suffix(first, values);
+        } else if (!expected.empty()) {
+            size_t i { next() % expected.size() };
+            expected[i] = next() % 1000;
+            tree.set(i, expected[i]);
+        }
+        ASSERT_EQ(tree.size(), expected.size());
+        size_t first { next() % (expected.size() + 1) };
+        size_t last { first + next() % (expected.size() - first + 1) };
+        uint32_t max { 0 };
+        uint64_t sum { 0 };
+        for (size_t i { first }; i < last; i++) {
+            max = std::max(max, expected[i]);
+            sum += expected[i];
+        }
+        EXPECT_EQ(tree.max(first, last), max);
+        EXPECT_EQ(tree.sum(first, last), sum);
+    }
+    EXPECT_THROW((void)tree.max(1, 0), std::out_of_range);
+    EXPECT_THROW(tree.set(expected.size(), 0), std::out_of_range);
+}
+
+
+// distâncias refeitas só a partir do instante alterado iguais às de uma solução montada do zero
+TEST_F(MTSPBCTest, DistanceTreeMatchesFullSweep) {
+    const MTSPBCInstance& cref = *instance;
+    MTSPBC solution { build_heuristic(cref, true) };
+    auto check { [&]() {
+        MTSPBC fresh(cref);
+        for (uint32_t k { 0 }; k < solution.get_k_vehicles(); k++) {
+            fresh.create_vehicle();
+            for (uint32_t node : solution.get_tour(k)) {
+                fresh.push_back(k, node);
+            }
+        }
+        std::vector<uint32_t> distances { fresh.get_distances() };
+        ASSERT_EQ(solution.get_distances(), distances);
+        uint64_t total { 0 };
+        for (uint32_t d : distances) {
+            total += d;
+        }
+        EXPECT_EQ(solution.get_distance_sum(), total);
+        auto timeline { solution.get_events() };
+        uint32_t last_time { timeline.back().first };
+        for (uint32_t t_1 : { 0u, last_time / 3, last_time / 2 }) {
+            uint32_t t_2 { t_1 + last_time / 4 };
+            uint32_t max { 0 };
+            uint64_t sum { 0 };
+            for (size_t e { 0 }; e < timeline.size(); e++) {
+                if (timeline[e].first >= t_1 && timeline[e].first <= t_2) {
+                    max = std::max(max, distances[e]);
+                    sum += distances[e];
+                }
+            }
+            EXPECT_EQ(solution.max_distance_in(t_1, t_2), max);
+            EXPECT_EQ(solution.distance_sum_in(t_1, t_2), sum);
+        }
+    } };
+    check();
+    uint32_t n { solution.n_nodes(0) };
+    uint32_t node { solution.get_node_at_pos(0, n - 2) };
+    solution.remove_node(0, n - 2);
+    check();
+    solution.insert_node(1, node, solution.n_nodes(1) - 1);
+    solution.reverse_subtour(1, solution.n_nodes(1) - 4, solution.n_nodes(1) - 1);
+    check();
+    solution.pop_back(0);
+    solution.push_back(0, 0);
+    check();
+    solution.begin();
+    solution.reverse_subtour(0, 1, 4);
+    (void)solution.get_distance_sum();
+    solution.rollback();
+    check();
+    // rotas em lista de dois níveis: várias alterações no meio antes da próxima leitura
+    solution.set_tour_backend(TourBackend::two_level);
+    for (uint32_t p { 2 }; p < 5; p++) {
+        solution.reverse_subtour(2, p, p + 3);
+        solution.remove_node(3, p);
+    }
+    check();
+    // transação em lista: o segundo checkpoint lê só o prefixo e o rollback descarta a lista
+    std::vector<uint32_t> before { solution.get_tour(2) };
+    solution.begin();
+    solution.reverse_subtour(2, 6, 9);
+    solution.reverse_subtour(2, 3, 7);
+    solution.remove_node(2, 2);
+    solution.rollback();
+    EXPECT_EQ(solution.get_tour(2), before);
+    check();
+    EXPECT_THROW((void)solution.max_distance_in(2, 1), std::logic_error);
+}
+
+
+TEST_F(MTSPBCTest, BatchedMutations) {
+    const MTSPBCInstance& cref = *instance;
+    MTSPBC solution { build_heuristic(cref, false) };
+    // vários movimentos sem consulta: a linha do tempo só é refeita no commit
+    for (uint32_t m { 1 }; m < 6; m++) {
+        uint32_t node { solution.get_node_at_pos(0, m) };
+        solution.remove_node(0, m);
+        solution.insert_node(1, node, m);
+    }
+    uint32_t committed { solution.commit() };
+    MTSPBC rebuilt(cref);
+    for (uint32_t k { 0 }; k < solution.get_k_vehicles(); k++) {
+        rebuilt.create_vehicle();
+        for (uint32_t node : solution.get_tour(k)) {
+            rebuilt.push_back(k, node);
+        }
+    }
+    EXPECT_EQ(committed, rebuilt.get_max_distance());
+    EXPECT_EQ(solution.get_events(), rebuilt.get_events());
+    EXPECT_EQ(solution.get_distances(), rebuilt.get_distances());
+}
+
+
+
+// remover um veículo renumera os seguintes: a linha do tempo é refeita sem os eventos dele
+TEST_F(MTSPBCTest, RemoveVehicleRebuildsTimeline) {
+    const MTSPBCInstance& cref = *instance;
+    MTSPBC solution { build_heuristic(cref, false) };
+    auto check { [&]() {
+        MTSPBC rebuilt(cref);
+        for (uint32_t k { 0 }; k < solution.get_k_vehicles(); k++) {
+            rebuilt.create_vehicle();
+            for (uint32_t node : solution.get_tour(k)) {
+                rebuilt.push_back(k, node);
+            }
+        }
+        EXPECT_EQ(solution.get_events(), rebuilt.get_events());
+        EXPECT_EQ(solution.get_distances(), rebuilt.get_distances());
+        EXPECT_EQ(solution.get_max_distance(), rebuilt.get_max_distance());
+    } };
+    ASSERT_GE(solution.get_k_vehicles(), 4u);
+    (void)solution.get_max_distance();
+    solution.remove_vehicle(solution.get_k_vehicles() - 1);
+    check();
+    solution.remove_vehicle(1);
+    check();
+}
+
+TEST_F(MTSPBCTest, RollbackRestoresState) {
+    const MTSPBCInstance& cref = *instance;
+    MTSPBC solution { build_heuristic(cref, false) };
+    MTSPBC before { solution };
+    auto same { [&](const MTSPBC& a, const MTSPBC& b) {
+        EXPECT_EQ(a.get_total_obj(), b.get_total_obj());
+        EXPECT_EQ(a.get_max_distance(), b.get_max_distance());
+        EXPECT_EQ(a.get_events(), b.get_events());
+        EXPECT_EQ(a.get_distances(), b.get_distances());
+        for (uint32_t k { 0 }; k < a.get_k_vehicles(); k++) {
+            EXPECT_EQ(a.get_tour(k), b.get_tour(k));
+            EXPECT_EQ(a.get_vehicle_events(k), b.get_vehicle_events(k));
+            EXPECT_EQ(a.get_obj_vehicle(k), b.get_obj_vehicle(k));
+        }
+    } };
+    // alterações em posições cada vez mais à frente, com consultas no meio
+    solution.begin();
+    uint32_t node { solution.get_node_at_pos(0, 5) };
+    solution.remove_node(0, 5);
+    solution.insert_node(1, node, 4);
+    (void)solution.get_max_distance();
+    solution.reverse_subtour(1, 1, 3);
+    solution.remove_node(0, 2);
+    solution.push_back(0, node);
+    solution.rollback();
+    same(solution, before);
+    EXPECT_FALSE(solution.in_transaction());
+    EXPECT_THROW(solution.rollback(), std::logic_error);
+
+    // sem consultas no meio: a linha do tempo não chega a ser refeita
+    solution.begin();
+    solution.reverse_tour(1);
+    EXPECT_THROW(solution.begin(), std::logic_error);
+    EXPECT_THROW(solution.create_vehicle(), std::logic_error);
+    solution.rollback();
+    same(solution, before);
+
+    solution.begin();
+    solution.remove_node(0, 1);
+    uint32_t committed { solution.commit() };
+    EXPECT_FALSE(solution.in_transaction());
+    before.remove_node(0, 1);
+    EXPECT_EQ(committed, before.get_max_distance());
+    same(solution, before);
+}
+
+
+TEST_F(MTSPBCTest, VehicleForNode) {
+    const MTSPBCInstance& cref = *instance;
+    MTSPBC solution { build_heuristic(cref, false) };
+    auto check { [&]() {
+        for (uint32_t node { 1 }; node < cref.n(); node++) {
+            std::optional<uint32_t> vehicle { solution.get_vehicle_for_node(node) };
+            bool visited { false };
+            for (uint32_t k { 0 }; k < solution.get_k_vehicles(); k++) {
+                visited |= solution.get_pos_for_node(k, node).has_value();
+            }
+            EXPECT_EQ(vehicle.has_value(), visited);
+            if (vehicle) {
+                EXPECT_TRUE(solution.get_pos_for_node(vehicle.value(), node).has_value());
+            }
+        }
+    } };
+    check();
+    uint32_t node { solution.get_node_at_pos(0, 3) };
+    solution.remove_node(0, 3);
+    EXPECT_FALSE(solution.get_vehicle_for_node(node).has_value());
+    solution.insert_node(1, node, 2);
+    EXPECT_EQ(solution.get_vehicle_for_node(node), 1);
+    check();
+    solution.begin();
+    solution.remove_node(1, 2);
+    solution.insert_node(0, node, 1);
+    EXPECT_EQ(solution.get_vehicle_for_node(node), 0);
+    solution.rollback();
+    EXPECT_EQ(solution.get_vehicle_for_node(node), 1);
+    check();
+}
+
+
+TEST_F(MTSPBCTest, ViewsMatchCopies) {
+    const MTSPBCInstance& cref = *instance;
+    MTSPBC solution { build_heuristic(cref, false) };
+    solution.remove_node(0, 2);
+    // as visões da linha do tempo sincronizam antes de serem lidas
+    auto timeline { solution.timeline_view() };
+    auto distances { solution.distances_view() };
+    EXPECT_EQ(std::vector(timeline.begin(), timeline.end()), solution.get_events());
+    EXPECT_EQ(std::vector(distances.begin(), distances.end()), solution.get_distances());
+    for (uint32_t k { 0 }; k < solution.get_k_vehicles(); k++) {
+        auto tour { solution.tour_view(k) };
+        auto events { solution.events_view(k) };
+        EXPECT_EQ(std::vector(tour.begin(), tour.end()), solution.get_tour(k));
+        EXPECT_EQ(std::vector(events.begin(), events.end()), solution.get_vehicle_events(k));
+    }
+    EXPECT_THROW((void)solution.tour_view(solution.get_k_vehicles()), std::logic_error);
+}
+
+
+TEST_F(MTSPBCTest, EvaluateMatchesApply) {
+    const MTSPBCInstance& cref = *instance;
+    MTSPBC solution { build_heuristic(cref, false) };
+    auto length { [](const MTSPBC& s) {
+        int64_t total { 0 };
+        for (uint32_t k { 0 }; k < s.get_k_vehicles(); k++) {
+            auto events { s.get_vehicle_events(k) };
+            total += events.empty() ? 0 : events.back();
+        }
+        return total;
+    } };
+    auto check { [&](const MoveDelta& delta, const MTSPBC& applied) {
+        EXPECT_EQ(delta.length, length(applied) - length(solution));
+        EXPECT_EQ(delta.max_distance, static_cast<int64_t>(applied.get_max_distance()) - solution.get_max_distance());
+    } };
+    for (uint32_t p { 1 }; p < 5; p++) {
+        uint32_t node { solution.get_node_at_pos(1, p) };
+        {
+            MTSPBC applied { solution };
+            applied.insert_node(0, node, p + 1);
+            check(solution.evaluate_insert(0, node, p + 1), applied);
+            EXPECT_EQ(solution.get_tour(0).size(), applied.get_tour(0).size() - 1);
+        }
+        {
+            MTSPBC applied { solution };
+            applied.remove_node(1, p);
+            check(solution.evaluate_remove(1, p), applied);
+        }
+        {
+            MTSPBC applied { solution };
+            applied.remove_node(1, p);
+            applied.insert_node(2, node, p);
+            check(solution.evaluate_relocate(1, p, 2, p), applied);
+        }
+        {
+            MTSPBC applied { solution };
+            uint32_t other { solution.get_node_at_pos(3, p + 1) };
+            applied.remove_node(1, p);
+            applied.insert_node(1, other, p);
+            applied.remove_node(3, p + 1);
+            applied.insert_node(3, node, p + 1);
+            check(solution.evaluate_swap(1, p, 3, p + 1), applied);
+        }
+        {
+            MTSPBC applied { solution };
+            applied.reverse_subtour(2, p, p + 3);
+            check(solution.evaluate_2opt(2, p, p + 3), applied);
+            EXPECT_EQ(solution.evaluate_2opt(2, p, p + 3).length, solution.get_tour(2).empty() ? 0 : length(applied) - length(solution));
+        }
+        {
+            // move os nós [p, p + 2) da rota 0 para antes da posição p + 3 da rota sem eles
+            MTSPBC applied { solution };
+            uint32_t a { solution.get_node_at_pos(0, p) };
+            uint32_t b { solution.get_node_at_pos(0, p + 1) };
+            applied.remove_node(0, p);
+            applied.remove_node(0, p);
+            applied.insert_node(0, b, p + 3);
+            applied.insert_node(0, a, p + 3);
+            check(solution.evaluate_or_opt(0, p, p + 2, p + 3), applied);
+        }
+    }    // alterações perto do fim: a separação antes delas vem de distance_tree_
+    for (uint32_t k { 0 }; k < solution.get_k_vehicles(); k++) {
+        const uint32_t n { solution.n_nodes(k) };
+        if (n < 6) {
+            continue;
+        }
+        MTSPBC removed { solution };
+        removed.remove_node(k, n - 2);
+        check(solution.evaluate_remove(k, n - 2), removed);
+        MTSPBC reversed { solution };
+        reversed.reverse_subtour(k, n - 5, n - 2);
+        check(solution.evaluate_2opt(k, n - 5, n - 2), reversed);
+    }
+}
+
+
+// a busca de realocação nunca piora a maior distância e mantém as rotas válidas;
+// a busca completa nesta instância é lenta sem otimização e fica para a instância pequena abaixo
+TEST_F(MTSPBCTest, MaxdBest3optImproves) {
+    const MTSPBCInstance& cref = *instance;
+    MTSPBC start { build_heuristic(cref, true) };
+    auto visited { [](const MTSPBC& s) {
+        std::vector<uint32_t> nodes;
+        for (uint32_t k { 0 }; k < s.get_k_vehicles(); k++) {
+            std::vector<uint32_t> tour { s.get_tour(k) };
+            EXPECT_GE(tour.size(), 2u);
+            EXPECT_EQ(tour.front(), 0u);
+            EXPECT_EQ(tour.back(), 0u);
+            nodes.insert(nodes.end(), tour.begin() + 1, tour.end() - 1);
+        }
+        std::sort(nodes.begin(), nodes.end());
+        return nodes;
+    } };
+    MTSPBC solution { start };
+    uint32_t result { maxd_best_3opt(solution, cref, true) };
+    EXPECT_LT(result, start.get_max_distance());
+    EXPECT_EQ(result, solution.get_max_distance());
+    EXPECT_EQ(visited(solution), visited(start));
+}
+
+
+// com todos os nós vizinhos entre si, a busca granular é a mesma que a completa
+TEST(MTSPBCSearchTest, GranularMatchesFullWhenAllNeighbours) {
+    std::vector<Coord> coords;
+    uint64_t state { 11 };
+    for (uint32_t i { 0 }; i < 12; i++) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        coords.push_back({ static_cast<double>((state >> 33) % 100), static_cast<double>((state >> 17) % 100) });
+    }
+    MTSPBCInstance small(std::move(coords), 3, 5);
+    ASSERT_EQ(small.n_neighbours(), small.n() - 1);
+    MTSPBC full(small);
+    for (uint32_t k { 0 }; k < small.k(); k++) {
+        full.create_vehicle();
+        full.push_back(k, 0);
+    }
+    for (uint32_t node { 1 }; node < small.n(); node++) {
+        full.push_back(node % small.k(), node);
+    }
+    for (uint32_t k { 0 }; k < small.k(); k++) {
+        full.push_back(k, 0);
+    }
+    MTSPBC granular { full };
+    const uint32_t before { full.get_max_distance() };
+    EXPECT_EQ(maxd_best_3opt(granular, small, true), maxd_best_3opt(full, small, false));
+    EXPECT_LT(full.get_max_distance(), before);
+    uint32_t n_visited { 0 };
+    for (uint32_t k { 0 }; k < small.k(); k++) {
+        EXPECT_EQ(granular.get_tour(k), full.get_tour(k));
+        EXPECT_EQ(full.get_tour(k).front(), 0u);
+        EXPECT_EQ(full.get_tour(k).back(), 0u);
+        n_visited += full.n_nodes(k) - 2;
+    }
+    EXPECT_EQ(n_visited, small.n() - 1);
+}
+
+
+// um nó sem janela de cobertura na aresta que o pula não é coberto e fica na rota
+TEST(RemoveCoveredNodesTest, KeepsNodesNoEdgeCovers) {
+    std::vector<Coord> coords { { 0, 0 }, { 1000, 0 }, { 1000, 1000 }, { 0, 1000 }, { 2000, 500 }, { 500, 1 } };
+    MTSPBCInstance small(std::move(coords), 1, 5);
+    auto run { [&](const std::vector<uint32_t>& nodes, std::vector<size_t>& un_nodes) {
+        MTSPBC solution(small);
+        solution.create_vehicle();
+        for (uint32_t node : nodes) {
+            solution.push_back(0, node);
+        }
+        remove_covered_nodes(solution, small, 0, un_nodes);
+        return solution.get_tour(0);
+    } };
+    std::vector<size_t> un_nodes;
+    EXPECT_FALSE(small.covers(1, 0, 4));
+    EXPECT_EQ(run({ 0, 1, 4, 2, 3 }, un_nodes), (std::vector<uint32_t> { 0, 1, 4, 2, 3 }));
+    EXPECT_TRUE(un_nodes.empty());
+    // o nó 5 fica a 1 da aresta 0 -> 1, dentro do raio: só ele sai
+    EXPECT_TRUE(small.covers(5, 0, 1));
+    EXPECT_EQ(run({ 0, 5, 1, 4, 2, 3 }, un_nodes), (std::vector<uint32_t> { 0, 1, 4, 2, 3 }));
+    EXPECT_EQ(un_nodes, (std::vector<size_t> { 5 }));
+}
+
+
+TEST_F(MTSPBCTest, ChtEvaluateMatchesApply) {
+    const MTSPBCInstance& cref = *instance;
+    Cht tour;
+    for (uint32_t node { 1 }; node < 12; node++) {
+        tour.push_back((node * 37) % cref.n(), cref);
+    }
+    auto length { [](const Cht& t) { return static_cast<int64_t>(t.get_events().back()); } };
+    for (uint32_t p { 0 }; p < tour.n_nodes(); p++) {
+        Cht inserted { tour };
+        inserted.insert_node(5, p, cref);
+        EXPECT_EQ(tour.evaluate_insert(5, p, cref), length(inserted) - length(tour));
+        Cht removed { tour };
+        removed.remove_node(p, cref);
+        EXPECT_EQ(tour.evaluate_remove(p, cref), length(removed) - length(tour));
+        for (uint32_t e { p }; e <= tour.n_nodes(); e++) {
+            std::vector<uint32_t> nodes { tour.get_tour() };
+            std::reverse(nodes.begin() + p, nodes.begin() + e);
+            Cht reversed;
+            for (uint32_t n : nodes) {
+                reversed.push_back(n, cref);
+            }
+            EXPECT_EQ(tour.evaluate_2opt(p, e, cref), length(reversed) - length(tour));
+            if (e > p) {
+                for (uint32_t to { 0 }; to <= tour.n_nodes() - (e - p); to++) {
+                    std::vector<uint32_t> original { tour.get_tour() };
+                    std::vector<uint32_t> rest { original };
+                    rest.erase(rest.begin() + p, rest.begin() + e);
+                    rest.insert(rest.begin() + to, original.begin() + p, original.begin() + e);
+                    Cht moved;
+                    for (uint32_t n : rest) {
+                        moved.push_back(n, cref);
+                    }
+                    EXPECT_EQ(tour.evaluate_or_opt(p, e, to, cref), length(moved) - length(tour));
+                }
+            }
+        }
+    }
+}
+
+
 TEST_F(MTSPBCTest, CloseTours) {
     const MTSPBCInstance& cref = *instance;
     MTSPBC solution(cref);